@@ -24,17 +24,58 @@ package ij3d;
 
 import java.awt.Rectangle;
 import java.awt.geom.Area;
+import java.awt.geom.PathIterator;
+import java.util.ArrayList;
+import java.util.Arrays;
 import java.util.List;
+import java.util.stream.IntStream;
 
 /**
  * Wraps a list of {@link Area}s to be triangulated.
+ * <p>
+ * The areas are rasterized once, on first use, into runs: for every row of
+ * every section, the spans of voxels inside any area of the section. Thin
+ * shapes on large canvases thus take memory in proportion to their outline
+ * rather than to the canvas. {@link #load} is a binary search over the spans
+ * of a row, and {@link #nextBoundary} tells where the row changes next.
+ * </p>
  *
  * @author Johannes Schindelin
  */
 public class AreaListVolume extends Volume {
 
+	/** Maximal distance of the flattened outlines from curved ones. */
+	private static final double FLATNESS = 0.01;
+
 	private final List<List<Area>> areas;
 
+	/* the voxel (0, 0) of a section is at (minX, minY) in area coordinates */
+	private final int minX, minY;
+
+	/* per section, its spans, or null if it is empty; see getSections() */
+	private volatile Section[] sections;
+
+	/**
+	 * The rows y0 to y0 + rows.length - 1 of a section. Each row is given by
+	 * the sorted boundaries x0 < x1 < x0' < x1' ... of its spans [x0, x1),
+	 * [x0', x1'), ..., or null if it is empty.
+	 */
+	private static final class Section {
+
+		final int y0;
+		final int[][] rows;
+
+		Section(final int y0, final int[][] rows) {
+			this.y0 = y0;
+			this.rows = rows;
+		}
+
+		int[] row(final int y) {
+			final int i = y - y0;
+			return i < 0 || i >= rows.length ? null : rows[i];
+		}
+	}
+
 	public AreaListVolume(final List<List<Area>> areas, final double zSpacing,
 		final double xOrigin, final double yOrigin, final double zOrigin)
 	{
@@ -59,6 +100,8 @@ public class AreaListVolume extends Volume {
 		xDim = bounds.width;
 		yDim = bounds.height;
 		zDim = areas.size();
+		minX = bounds.x;
+		minY = bounds.y;
 
 		maxCoord.x = minCoord.x + xDim * pw;
 		maxCoord.y = minCoord.y + yDim * ph;
@@ -92,13 +135,151 @@ public class AreaListVolume extends Volume {
 
 	@Override
 		public int load(final int x, final int y, final int z) {
-		if (z < 0 || z >= areas.size()) return 0;
-		final List<Area> list = areas.get(z);
-		if (list == null) return 0;
+		final int[] spans = spans(y, z);
+		if (spans == null) return 0;
+		// x is inside if an odd number of boundaries is <= x
+		final int i = Arrays.binarySearch(spans, x);
+		final int below = i >= 0 ? i + 1 : -i - 1;
+		return (below & 1) != 0 ? 0xff : 0;
+	}
+
+	/**
+	 * Returns the first x' > x at which {@link #load}(x', y, z) may differ
+	 * from load(x, y, z), or Integer.MAX_VALUE if there is none.
+	 */
+	public int nextBoundary(final int x, final int y, final int z) {
+		final int[] spans = spans(y, z);
+		if (spans == null) return Integer.MAX_VALUE;
+		final int i = Arrays.binarySearch(spans, x);
+		final int next = i >= 0 ? i + 1 : -i - 1;
+		return next < spans.length ? spans[next] : Integer.MAX_VALUE;
+	}
+
+	/** the span boundaries of row y of section z, or null if it is empty */
+	private int[] spans(final int y, final int z) {
+		if (z < 0 || z >= areas.size()) return null;
+		final Section section = getSections()[z];
+		return section == null ? null : section.row(y);
+	}
+
+	/**
+	 * The spans of all sections, rasterized in parallel the first time they
+	 * are needed.
+	 */
+	private Section[] getSections() {
+		final Section[] s = sections;
+		if (s != null) return s;
+		synchronized (this) {
+			if (sections == null) {
+				final Section[] rasterized = new Section[areas.size()];
+				IntStream.range(0, rasterized.length).parallel().forEach(
+					z -> rasterized[z] = rasterize(areas.get(z)));
+				sections = rasterized;
+			}
+			return sections;
+		}
+	}
+
+	/**
+	 * Rasterizes the union of the given areas with a scanline fill of their
+	 * flattened outlines. The voxel (x, y) is inside if the point (x, y) is,
+	 * with the insideness rules of {@link Area#contains(double, double)}: a
+	 * point on the outline is inside if the interior lies to its right, or
+	 * below it on a horizontal edge.
+	 */
+	private Section rasterize(final List<Area> list) {
+		if (list == null || list.isEmpty()) return null;
+		// unlike in the constructor, (0, 0) is not part of the bounds
+		Rectangle bounds = null;
+		for (final Area area : list) {
+			if (area == null) continue;
+			bounds = bounds == null ? area.getBounds() : bounds.union(area.getBounds());
+		}
+		if (bounds == null) return null;
+		final int y0 = Math.max(bounds.y, minY);
+		final int y1 = Math.min(bounds.y + bounds.height, minY + yDim - 1);
+		if (y1 < y0) return null;
+
+		// per row, the spans of all areas as x0, x1
+		final List<List<int[]>> rowSpans = new ArrayList<List<int[]>>();
+		for (int y = y0; y <= y1; y++)
+			rowSpans.add(new ArrayList<int[]>());
+		final double[] c = new double[6];
 		for (final Area area : list) {
-			if (area.contains(x, y)) return 0xff;
-		};
-		return 0;
+			if (area == null) continue;
+			// the edges, as x0, y0, x1, y1
+			final List<double[]> edges = new ArrayList<double[]>();
+			final PathIterator pit = area.getPathIterator(null, FLATNESS);
+			final boolean evenOdd =
+				pit.getWindingRule() == PathIterator.WIND_EVEN_ODD;
+			double sx = 0, sy = 0, px = 0, py = 0;
+			for (; !pit.isDone(); pit.next()) {
+				switch (pit.currentSegment(c)) {
+					case PathIterator.SEG_MOVETO:
+						sx = px = c[0];
+						sy = py = c[1];
+						break;
+					case PathIterator.SEG_LINETO:
+						edges.add(new double[] { px, py, c[0], c[1] });
+						px = c[0];
+						py = c[1];
+						break;
+					case PathIterator.SEG_CLOSE:
+						edges.add(new double[] { px, py, sx, sy });
+						px = sx;
+						py = sy;
+						break;
+				}
+			}
+
+			// per row, the crossings of the scanline as x and direction
+			final double[][] crossings = new double[edges.size()][2];
+			final Rectangle b = area.getBounds();
+			for (int y = Math.max(b.y, y0); y <= Math.min(b.y + b.height, y1); y++) {
+				int n = 0;
+				for (final double[] e : edges) {
+					if ((e[1] <= y) == (e[3] <= y)) continue;
+					crossings[n][0] = e[0] + (y - e[1]) * (e[2] - e[0]) / (e[3] - e[1]);
+					crossings[n++][1] = e[3] > e[1] ? 1 : -1;
+				}
+				Arrays.sort(crossings, 0, n, (p, q) -> Double.compare(p[0], q[0]));
+				int winding = 0;
+				int start = 0;
+				for (int i = 0; i < n; i++) {
+					final boolean inside = evenOdd ? (winding & 1) != 0 : winding != 0;
+					winding += (int) crossings[i][1];
+					final boolean after = evenOdd ? (winding & 1) != 0 : winding != 0;
+					if (!inside && after) start = (int) Math.ceil(crossings[i][0]);
+					else if (inside && !after) {
+						// clipped to the volume
+						final int x0 = Math.max(start, minX);
+						final int x1 = Math.min((int) Math.ceil(crossings[i][0]),
+							minX + xDim);
+						if (x0 < x1) rowSpans.get(y - y0).add(new int[] { x0, x1 });
+					}
+				}
+			}
+		}
+
+		// merge the overlapping and adjacent spans of each row
+		final int[][] rows = new int[y1 - y0 + 1][];
+		for (int y = 0; y < rows.length; y++) {
+			final List<int[]> spans = rowSpans.get(y);
+			if (spans.isEmpty()) continue;
+			spans.sort((p, q) -> Integer.compare(p[0], q[0]));
+			final int[] merged = new int[2 * spans.size()];
+			int n = 0;
+			for (final int[] span : spans) {
+				if (n > 0 && span[0] <= merged[n - 1]) {
+					merged[n - 1] = Math.max(merged[n - 1], span[1]);
+					continue;
+				}
+				merged[n++] = span[0];
+				merged[n++] = span[1];
+			}
+			rows[y] = Arrays.copyOf(merged, n);
+		}
+		return new Section(y0, rows);
 	}
 
 	@Override
@@ -0,0 +1,213 @@
+/*-
+ * #%L
+ * Fiji distribution of ImageJ for the life sciences.
+ * %%
+ * Copyright (C) 2010 - 2016 Fiji developers.
+ * %%
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/gpl-3.0.html>.
+ * #L%
+ */
+
+package marchingcubes;
+
+import java.awt.Rectangle;
+import java.awt.geom.Area;
+import java.awt.geom.Ellipse2D;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+
+import org.scijava.vecmath.Point3f;
+
+import ij.ImagePlus;
+import ij.ImageStack;
+import ij3d.AreaListVolume;
+import ij3d.Volume;
+
+/**
+ * Tests of the {@link AreaListVolume} helper of {@link MCCube}: the cubes
+ * are scanned in parallel tiles, skipping the cubes between span
+ * boundaries, which must give the triangles of the plain sweep over the
+ * same voxels, rasterized into an image. The shapes have holes, several
+ * disjoint areas per section, reach to negative coordinates, where the
+ * Carrier reads zero, and are large enough to be cut into several tiles.
+ *
+ * @author Benjamin Schmid
+ */
+public class AreaListVolumeTest {
+
+	private static final int THRESHOLD = 128;
+
+	private static int failures = 0;
+
+	private static void check(final boolean ok, final String what) {
+		if (!ok) {
+			System.out.println("FAILED: " + what);
+			failures++;
+		}
+	}
+
+	/** one string per triangle, sorted, to compare triangles in any order */
+	private static List<String> sorted(final List<Point3f> tri) {
+		final List<String> out = new ArrayList<String>();
+		for (int i = 0; i + 2 < tri.size(); i += 3)
+			out.add(tri.get(i) + " " + tri.get(i + 1) + " " + tri.get(i + 2));
+		Collections.sort(out);
+		return out;
+	}
+
+	/** the voxels the Carrier of the volume reads, as an 8 bit image */
+	private static ImagePlus rasterize(final AreaListVolume volume) {
+		final ImageStack stack = new ImageStack(volume.xDim, volume.yDim);
+		for (int z = 0; z < volume.zDim; z++) {
+			final byte[] pixels = new byte[volume.xDim * volume.yDim];
+			for (int y = 0; y < volume.yDim; y++)
+				for (int x = 0; x < volume.xDim; x++)
+					pixels[y * volume.xDim + x] = (byte) volume.load(x, y, z);
+			stack.addSlice("", pixels);
+		}
+		return new ImagePlus("rasterized", stack);
+	}
+
+	/**
+	 * Compares the triangles of the AreaListVolume helper with the ones of
+	 * the plain sweep over the rasterized volume; both are in pixel
+	 * coordinates, as spacing and origin are 1 and 0.
+	 */
+	private static void compare(final List<List<Area>> areas, final String what) {
+		final AreaListVolume volume = new AreaListVolume(areas, 1, 0, 0, 0);
+		final List<Point3f> skipped = MCCube.getTriangles(volume, THRESHOLD);
+		final List<Point3f> all = MCCube.getTriangles(
+			new Volume(rasterize(volume)), THRESHOLD);
+		check(!all.isEmpty(), what + ": the areas have triangles");
+		check(sorted(skipped).equals(sorted(all)),
+			what + ": skipping spans gives the triangles of all cubes");
+	}
+
+	/** a ring: a disk with a hole, centered at (cx, cy) */
+	private static Area ring(final double cx, final double cy, final double r) {
+		final Area a = new Area(new Ellipse2D.Double(cx - r, cy - r, 2 * r, 2 * r));
+		a.subtract(new Area(new Ellipse2D.Double(cx - r / 2, cy - r / 2, r, r)));
+		return a;
+	}
+
+	/** areas reaching to negative x and y, as rectangles and an overlapping pair */
+	private static void testNegativeOrigin() {
+		final List<List<Area>> areas = new ArrayList<List<Area>>();
+		for (int z = 0; z < 4; z++) {
+			final List<Area> section = new ArrayList<Area>();
+			section.add(new Area(new Rectangle(-7, -5, 20 + z, 12)));
+			section.add(new Area(new Rectangle(3, -9, 4, 30 - 3 * z)));
+			areas.add(section);
+		}
+		compare(areas, "negative origin");
+	}
+
+	/** rings, which have holes, next to disjoint rectangles, and empty sections */
+	private static void testHolesAndDisjointAreas() {
+		final List<List<Area>> areas = new ArrayList<List<Area>>();
+		for (int z = 0; z < 6; z++) {
+			final List<Area> section = new ArrayList<Area>();
+			if (z != 3) {
+				section.add(ring(20 + z, 20, 12));
+				section.add(new Area(new Rectangle(40, 5 + z, 6, 9)));
+				section.add(new Area(new Rectangle(50, 30, 3, 3)));
+				// a rectangle with a rectangular hole
+				final Area frame = new Area(new Rectangle(5, 40, 30, 12));
+				frame.subtract(new Area(new Rectangle(10, 43, 20 - 2 * z, 6)));
+				section.add(frame);
+			}
+			areas.add(section);
+		}
+		compare(areas, "holes and disjoint areas");
+	}
+
+	/** an area of far more than TILE_CUBES cubes per section, cut into tiles */
+	private static void testTiles() {
+		final List<List<Area>> areas = new ArrayList<List<Area>>();
+		for (int z = 0; z < 3; z++) {
+			final List<Area> section = new ArrayList<Area>();
+			final Area a = new Area(new Ellipse2D.Double(0, 0, 400, 150 + 10 * z));
+			a.subtract(ring(200, 80, 40));
+			section.add(a);
+			areas.add(section);
+		}
+		compare(areas, "tiles");
+	}
+
+	/**
+	 * Checks that disjoint() gives n rectangles which do not overlap and
+	 * cover exactly the cells of the given ones.
+	 */
+	private static void checkDisjoint(final List<Rectangle> rects, final int n,
+		final String what)
+	{
+		final List<Rectangle> out = MCCube.disjoint(rects);
+		final Rectangle bounds = new Rectangle();
+		for (final Rectangle r : rects) bounds.add(r);
+		for (int i = 0; i < out.size(); i++)
+			for (int j = 0; j < i; j++)
+				check(!out.get(i).intersects(out.get(j)), what + ": rectangles are disjoint");
+		for (int y = bounds.y - 1; y <= bounds.y + bounds.height; y++)
+			for (int x = bounds.x - 1; x <= bounds.x + bounds.width; x++) {
+				boolean in = false, covered = false;
+				for (final Rectangle r : rects) in |= r.contains(x, y);
+				for (final Rectangle r : out) covered |= r.contains(x, y);
+				check(in == covered, what + ": the cells of the union are covered");
+			}
+		check(out.size() == n, what + ": " + n + " rectangles");
+	}
+
+	/** disjoint() cuts overlapping rectangles into bands and merges them */
+	private static void testDisjoint() {
+		// the bands [0, 2) and [2, 5), and [5, 6) and [6, 10), have the same
+		// intervals and are joined
+		final List<Rectangle> rects = new ArrayList<Rectangle>();
+		rects.add(new Rectangle(0, 0, 10, 10));
+		rects.add(new Rectangle(5, 5, 10, 10));
+		rects.add(new Rectangle(0, 2, 3, 4));
+		checkDisjoint(rects, 3, "overlapping rectangles");
+
+		// a frame: the band [2, 8) has two intervals, and the top and bottom
+		// bands have the same interval but are not adjacent
+		final List<Rectangle> frame = new ArrayList<Rectangle>();
+		frame.add(new Rectangle(0, 0, 10, 2));
+		frame.add(new Rectangle(0, 8, 10, 2));
+		frame.add(new Rectangle(0, 0, 2, 10));
+		frame.add(new Rectangle(8, 0, 2, 10));
+		checkDisjoint(frame, 4, "frame");
+
+		// rectangles which only touch, and one inside another
+		final List<Rectangle> touching = new ArrayList<Rectangle>();
+		touching.add(new Rectangle(-4, -3, 4, 6));
+		touching.add(new Rectangle(0, -3, 5, 6));
+		touching.add(new Rectangle(-2, -1, 3, 2));
+		checkDisjoint(touching, 1, "touching rectangles");
+
+		// a single rectangle, and none, are returned as they are
+		check(MCCube.disjoint(rects.subList(0, 1)).equals(rects.subList(0, 1)),
+			"a single rectangle");
+		check(MCCube.disjoint(new ArrayList<Rectangle>()).isEmpty(), "no rectangles");
+	}
+
+	public static void main(final String[] args) {
+		testNegativeOrigin();
+		testHolesAndDisjointAreas();
+		testTiles();
+		testDisjoint();
+		if (failures == 0) System.out.println("AreaListVolumeTest: passed");
+		System.exit(failures == 0 ? 0 : 1);
+	}
+}
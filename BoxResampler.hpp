@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BR_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "ContiguousImage.hpp"
+
+/**
+ * Downsamples a volume by an integer factor f in each direction: the voxel
+ * (x, y, z) of the result is the mean of the source voxels (x, y, z) * f to
+ * (x, y, z) * f + f - 1, fewer at the upper borders, the layout of
+ * NaiveResampler and of DownsamplingCascade. Integer means are truncated;
+ * RGB voxels (int) are averaged per channel.
+ *
+ * The box filter is separable: for a row of the result, the f x f source
+ * rows it covers (across z and y) are added into one row of sums, whose
+ * columns are then summed f by f. Rows are added with SSE2, and so are the
+ * columns for f = 2. Only a row of sums per channel and thread is kept;
+ * threads work on their own output slices.
+ */
+namespace BoxResampler {
+
+	/**
+	 * Per voxel type: the accumulator type, the number of channels, channel c
+	 * of a voxel, and the voxel of the channel values
+	 */
+	template <typename T>
+	struct Voxel {
+		typedef uint32_t Acc;
+		static const int CHANNELS = 1;
+		static Acc channel(T v, int) { return (Acc)v; }
+		static T pack(const Acc* c) { return (T)c[0]; }
+	};
+
+	template <>
+	struct Voxel<signed char> {
+		typedef uint32_t Acc;
+		static const int CHANNELS = 1;
+		static Acc channel(signed char v, int) { return v & 0xff; }
+		static signed char pack(const Acc* c) { return (signed char)c[0]; }
+	};
+
+	template <>
+	struct Voxel<short> {
+		typedef uint32_t Acc;
+		static const int CHANNELS = 1;
+		static Acc channel(short v, int) { return v & 0xffff; }
+		static short pack(const Acc* c) { return (short)c[0]; }
+	};
+
+	template <>
+	struct Voxel<float> {
+		typedef float Acc;
+		static const int CHANNELS = 1;
+		static Acc channel(float v, int) { return v; }
+		static float pack(const Acc* c) { return c[0]; }
+	};
+
+	/** RGB: red, green and blue; the result is opaque */
+	template <>
+	struct Voxel<int> {
+		typedef uint32_t Acc;
+		static const int CHANNELS = 3;
+		static Acc channel(int v, int c) { return (v >> (16 - 8 * c)) & 0xff; }
+		static int pack(const Acc* c) {
+			return (int)(0xff000000u | c[0] << 16 | c[1] << 8 | c[2]);
+		}
+	};
+
+	/** acc[i] += channel c of src[i], for i < n */
+	template <typename T>
+	inline void addChannel(const T* src, int c,
+		typename Voxel<T>::Acc* acc, int n)
+	{
+		for (int i = 0; i < n; i++)
+			acc[i] += Voxel<T>::channel(src[i], c);
+	}
+
+#if defined(BR_SSE2)
+	inline void addChannel(const signed char* src, int, uint32_t* acc, int n) {
+		const __m128i zero = _mm_setzero_si128();
+		int i = 0;
+		for (; i + 16 <= n; i += 16) {
+			const __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+			const __m128i lo = _mm_unpacklo_epi8(v, zero);
+			const __m128i hi = _mm_unpackhi_epi8(v, zero);
+			__m128i* a = (__m128i*)(acc + i);
+			_mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a),
+				_mm_unpacklo_epi16(lo, zero)));
+			_mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1),
+				_mm_unpackhi_epi16(lo, zero)));
+			_mm_storeu_si128(a + 2, _mm_add_epi32(_mm_loadu_si128(a + 2),
+				_mm_unpacklo_epi16(hi, zero)));
+			_mm_storeu_si128(a + 3, _mm_add_epi32(_mm_loadu_si128(a + 3),
+				_mm_unpackhi_epi16(hi, zero)));
+		}
+		for (; i < n; i++)
+			acc[i] += src[i] & 0xff;
+	}
+
+	inline void addChannel(const short* src, int, uint32_t* acc, int n) {
+		const __m128i zero = _mm_setzero_si128();
+		int i = 0;
+		for (; i + 8 <= n; i += 8) {
+			const __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i* a = (__m128i*)(acc + i);
+			_mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a),
+				_mm_unpacklo_epi16(v, zero)));
+			_mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1),
+				_mm_unpackhi_epi16(v, zero)));
+		}
+		for (; i < n; i++)
+			acc[i] += src[i] & 0xffff;
+	}
+
+	inline void addChannel(const float* src, int, float* acc, int n) {
+		int i = 0;
+		for (; i + 4 <= n; i += 4)
+			_mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i),
+				_mm_loadu_ps(src + i)));
+		for (; i < n; i++)
+			acc[i] += src[i];
+	}
+
+	inline void addChannel(const int* src, int c, uint32_t* acc, int n) {
+		const __m128i mask = _mm_set1_epi32(0xff);
+		const __m128i shift = _mm_cvtsi32_si128(16 - 8 * c);
+		int i = 0;
+		for (; i + 4 <= n; i += 4) {
+			const __m128i v = _mm_and_si128(_mm_srl_epi32(
+				_mm_loadu_si128((const __m128i*)(src + i)), shift), mask);
+			__m128i* a = (__m128i*)(acc + i);
+			_mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), v));
+		}
+		for (; i < n; i++)
+			acc[i] += Voxel<int>::channel(src[i], c);
+	}
+#endif
+
+	/**
+	 * out[i] = the sum of in[i * f] to in[i * f + f - 1], for the
+	 * (n + f - 1) / f sums of the n values of in
+	 */
+	inline void sumColumns(const uint32_t* in, int n, int f, uint32_t* out) {
+		int i = 0;
+#if defined(BR_SSE2)
+		if (f == 2) {
+			// the even and the odd values of 8, added
+			for (; 2 * i + 8 <= n; i += 4) {
+				const __m128 a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(in + 2 * i)));
+				const __m128 b = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(in + 2 * i + 4)));
+				_mm_storeu_si128((__m128i*)(out + i), _mm_add_epi32(
+					_mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))),
+					_mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)))));
+			}
+		}
+#endif
+		for (; i * f < n; i++) {
+			uint32_t s = 0;
+			for (int x = i * f; x < std::min(n, i * f + f); x++)
+				s += in[x];
+			out[i] = s;
+		}
+	}
+
+	inline void sumColumns(const float* in, int n, int f, float* out) {
+		int i = 0;
+#if defined(BR_SSE2)
+		if (f == 2) {
+			for (; 2 * i + 8 <= n; i += 4) {
+				const __m128 a = _mm_loadu_ps(in + 2 * i);
+				const __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+				_mm_storeu_ps(out + i, _mm_add_ps(
+					_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+					_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))));
+			}
+		}
+#endif
+		for (; i * f < n; i++) {
+			float s = 0;
+			for (int x = i * f; x < std::min(n, i * f + f); x++)
+				s += in[x];
+			out[i] = s;
+		}
+	}
+
+	/**
+	 * Downsamples the given slices of w x h voxels by f, using nThreads
+	 * threads (all cores if nThreads <= 0). Sums are kept in 32 bits, which
+	 * is enough for f < 40 with 16 bit voxels.
+	 */
+	template <typename T>
+	ContiguousImage<T> resample(const T* const* slices, int w, int h, int d,
+		int f, int nThreads)
+	{
+		typedef typename Voxel<T>::Acc Acc;
+		const int C = Voxel<T>::CHANNELS;
+		f = std::max(1, f);
+		const int ow = (w + f - 1) / f, oh = (h + f - 1) / f, od = (d + f - 1) / f;
+		ContiguousImage<T> out(ow, oh, od);
+		if (nThreads <= 0)
+			nThreads = (int)std::thread::hardware_concurrency();
+		nThreads = std::max(1, std::min(nThreads, od));
+
+		std::vector<std::thread> workers;
+		for (int t = 0; t < nThreads; t++) {
+			const int z0 = (int)((long long)od * t / nThreads);
+			const int z1 = (int)((long long)od * (t + 1) / nThreads);
+			workers.push_back(std::thread([&, z0, z1]() {
+				// per channel: a row of sums over z and y, and the sums over
+				// z, y and x
+				std::vector<Acc> rows((size_t)C * w), sums((size_t)C * ow);
+				Acc channels[C];
+				for (int oz = z0; oz < z1; oz++) {
+					const int zEnd = std::min(d, oz * f + f);
+					T* dst = out.slice(oz);
+					for (int oy = 0; oy < oh; oy++) {
+						const int yEnd = std::min(h, oy * f + f);
+						std::fill(rows.begin(), rows.end(), Acc());
+						for (int c = 0; c < C; c++) {
+							for (int z = oz * f; z < zEnd; z++)
+								for (int y = oy * f; y < yEnd; y++)
+									addChannel(slices[z] + (size_t)y * w, c,
+										&rows[(size_t)c * w], w);
+							sumColumns(&rows[(size_t)c * w], w, f, &sums[(size_t)c * ow]);
+						}
+						const int n = (zEnd - oz * f) * (yEnd - oy * f);
+						for (int ox = 0; ox < ow; ox++) {
+							const int count = n * (std::min(w, ox * f + f) - ox * f);
+							for (int c = 0; c < C; c++)
+								channels[c] = sums[(size_t)c * ow + ox] / (Acc)count;
+							dst[(size_t)oy * ow + ox] = Voxel<T>::pack(channels);
+						}
+					}
+				}
+			}));
+		}
+		for (size_t i = 0; i < workers.size(); i++)
+			workers[i].join();
+		return out;
+	}
+}
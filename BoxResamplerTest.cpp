@@ -0,0 +1,89 @@
+/**
+ * Tests of BoxResampler against the mean of each box computed voxel by
+ * voxel, for all voxel types, factors 1 to 5, and sizes which are not
+ * multiples of the factor or of a vector width.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "BoxResampler.hpp"
+
+static int failures = 0;
+
+/**
+ * Downsamples random w x h x d voxels by f and returns the number of
+ * voxels which differ from the truncated mean of their box.
+ */
+template <typename T>
+static int resample(int w, int h, int d, int f, std::mt19937& random) {
+	typedef BoxResampler::Voxel<T> Voxel;
+	typedef typename Voxel::Acc Acc;
+	std::vector<std::vector<T>> data(d, std::vector<T>((size_t)w * h));
+	std::vector<const T*> slices(d);
+	for (int z = 0; z < d; z++) {
+		for (size_t i = 0; i < data[z].size(); i++)
+			data[z][i] = std::is_floating_point<T>::value ?
+				(T)((random() % 1000) / 7.0f) : (T)random();
+		slices[z] = data[z].data();
+	}
+	const ContiguousImage<T> out = BoxResampler::resample<T>(slices.data(),
+		w, h, d, f, 3);
+	if (out.w != (w + f - 1) / f || out.h != (h + f - 1) / f ||
+		out.d != (d + f - 1) / f)
+		return 1;
+
+	int wrong = 0;
+	for (int z = 0; z < out.d; z++)
+		for (int y = 0; y < out.h; y++)
+			for (int x = 0; x < out.w; x++) {
+				Acc channels[3];
+				for (int c = 0; c < Voxel::CHANNELS; c++) {
+					Acc sum = 0;
+					int n = 0;
+					for (int zz = z * f; zz < std::min(d, z * f + f); zz++)
+						for (int yy = y * f; yy < std::min(h, y * f + f); yy++)
+							for (int xx = x * f; xx < std::min(w, x * f + f); xx++) {
+								sum += Voxel::channel(data[zz][(size_t)yy * w + xx], c);
+								n++;
+							}
+					channels[c] = sum / (Acc)n;
+				}
+				const T expected = Voxel::pack(channels);
+				const T actual = out.get(x, y, z);
+				// float sums are added in a different order
+				if (std::is_floating_point<T>::value ?
+					std::fabs((double)expected - actual) > 1e-4 * std::fabs((double)expected) + 1e-4 :
+					expected != actual)
+					wrong++;
+			}
+	return wrong;
+}
+
+template <typename T>
+static void check(const char* type, int w, int h, int d, int f, std::mt19937& random) {
+	const int wrong = resample<T>(w, h, d, f, random);
+	if (wrong != 0) {
+		std::printf("FAILED: %s %d x %d x %d by %d: %d voxels differ\n",
+			type, w, h, d, f, wrong);
+		failures++;
+	}
+}
+
+int main() {
+	std::mt19937 random(1);
+	const int widths[] = { 1, 7, 16, 33 };
+	for (int f = 1; f <= 5; f++)
+		for (int w : widths) {
+			check<signed char>("8 bit", w, 13, 9, f, random);
+			check<short>("16 bit", w, 13, 9, f, random);
+			check<float>("32 bit", w, 13, 9, f, random);
+			check<int>("RGB", w, 13, 9, f, random);
+		}
+	if (failures == 0) std::printf("BoxResamplerTest: passed\n");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ContiguousImage.hpp"
+
+/**
+ * The voxels of a volume in cubic bricks of edge x edge x edge voxels, edge
+ * being a power of two. The bricks follow each other in x, y, z order; inside
+ * a brick, the voxels are in Morton (Z) order, i.e. the bits of x, y and z
+ * are interleaved. A voxel and its neighbours in all three directions are
+ * thus mostly in the same brick and close to each other, rather than a row
+ * and a slice apart, so that 3D neighbourhoods touch few cache lines and
+ * pages. Bricks at the upper borders are partially unused.
+ *
+ * Same get(x, y, z) and set(x, y, z, v) as ContiguousImage; loops reading a
+ * BrickedImage should visit it brick by brick (see BRICK). The marching
+ * cubes sweep (MCCube) reads it layer by layer, in 2D tiles of one brick
+ * each; it gains from the layout within a layer, not across layers.
+ */
+template <typename T>
+class BrickedImage {
+public:
+	// the default edge length of a brick
+	static const int BRICK = 16;
+
+	int w, h, d;
+	int edge;
+
+	BrickedImage() : w(0), h(0), d(0), edge(0), shift(0), nbx(0), nby(0),
+		morton(nullptr) {}
+
+	/**
+	 * Copies the given slices of w x h voxels into bricks of the given edge
+	 * length, which is rounded up to a power of two.
+	 */
+	BrickedImage(const T* const* slices, int w, int h, int d, int edge = BRICK)
+		: w(w), h(h), d(d), edge(1), shift(0)
+	{
+		while (this->edge < edge) {
+			this->edge <<= 1;
+			shift++;
+		}
+		nbx = (w + this->edge - 1) >> shift;
+		nby = (h + this->edge - 1) >> shift;
+		const int nbz = (d + this->edge - 1) >> shift;
+		const int brickVolume = this->edge * this->edge * this->edge;
+		storage = ContiguousImage<T>(brickVolume, nbx * nby * nbz, 1);
+
+		// x with its bits spread to every third bit; y and z are shifted
+		std::shared_ptr<std::vector<uint32_t>> m =
+			std::make_shared<std::vector<uint32_t>>(this->edge, 0);
+		for (int i = 0; i < this->edge; i++)
+			for (int b = 0; b < shift; b++)
+				(*m)[i] |= (uint32_t)((i >> b) & 1) << (3 * b);
+		mortonTable = m;
+		morton = m->data();
+
+		for (int z = 0; z < d; z++) {
+			const T* slice = slices[z];
+			for (int y = 0; y < h; y++)
+				for (int x = 0; x < w; x++)
+					storage.data[index(x, y, z)] = slice[(size_t)y * w + x];
+		}
+	}
+
+	bool empty() const {
+		return storage.empty();
+	}
+
+	size_t index(int x, int y, int z) const {
+		const int mask = edge - 1;
+		const size_t brick = ((size_t)(z >> shift) * nby + (y >> shift)) * nbx +
+			(x >> shift);
+		return brick * storage.w + (morton[x & mask] | morton[y & mask] << 1 |
+			morton[z & mask] << 2);
+	}
+
+	T get(int x, int y, int z) const {
+		return storage.data[index(x, y, z)];
+	}
+
+	void set(int x, int y, int z, T v) {
+		storage.data[index(x, y, z)] = v;
+	}
+
+private:
+	int shift;
+	// number of bricks along x and y
+	int nbx, nby;
+	// one brick per row
+	ContiguousImage<T> storage;
+	// Morton code of the bits of a coordinate within a brick
+	std::shared_ptr<const std::vector<uint32_t>> mortonTable;
+	const uint32_t* morton;
+};
@@ -1,5 +1,6 @@
 #include "thirdparties/include/glm/vec3.hpp"
 #include "Carrier.hpp"
+#include "MinMaxPyramid.hpp"
 	/**
 	 * An encapsulating class to avoid thread collisions on static fields.
 	 */
@@ -9,12 +10,13 @@ private:
 	//Volume volume;
 	int volume;
 	float threshold;
+	const MinMaxPyramid* pyramid = nullptr;
 
 public:
 	Carrier() {
 	}
 
-	int intensity(glm::vec3 p) {
+	int intensity(glm::vec3 p) const {
 		if (p.x < 0 || p.y < 0 || p.z < 0 || p.x >= w || p.y >= h || p.z >= d)
 		{
 			return 0;
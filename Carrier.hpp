@@ -1,12 +1,16 @@
 #pragma once
 
+class MinMaxPyramid;
+
 class Carrier {
 public:
 	int w, h, d;
 	//Volume volume;
 	int volume;
 	float threshold;
+	// min/max pyramid of the volume, or null to scan every cube
+	const MinMaxPyramid* pyramid = nullptr;
 
 
-	int intensity(glm::vec3 p);
+	int intensity(glm::vec3 p) const;
 };
\ No newline at end of file
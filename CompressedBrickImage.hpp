@@ -0,0 +1,241 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/**
+ * A small byte oriented run length codec. The code is a sequence of tokens:
+ * a control byte c < 0x80 followed by c + 1 literal bytes, or a control byte
+ * c >= 0x80 followed by one byte which is repeated c - 0x80 + MIN_RUN times.
+ */
+namespace ByteCodec {
+
+	static const int MIN_RUN = 3;
+	static const int MAX_RUN = 0x7f + MIN_RUN;
+	static const int MAX_LITERAL = 0x80;
+
+	/** appends the code of the n bytes at in to out */
+	inline void encode(const unsigned char* in, size_t n,
+		std::vector<unsigned char>& out)
+	{
+		size_t literal = 0, i = 0;
+		while (i < n) {
+			size_t run = 1;
+			while (i + run < n && run < MAX_RUN && in[i + run] == in[i]) run++;
+			if (run >= MIN_RUN) {
+				out.push_back((unsigned char)(0x80 + run - MIN_RUN));
+				out.push_back(in[i]);
+				i += run;
+				continue;
+			}
+			// a literal token, up to the next run
+			literal = 0;
+			while (i + literal < n && literal < MAX_LITERAL) {
+				const size_t j = i + literal;
+				if (j + MIN_RUN <= n && in[j] == in[j + 1] && in[j] == in[j + 2])
+					break;
+				literal++;
+			}
+			out.push_back((unsigned char)(literal - 1));
+			out.insert(out.end(), in + i, in + i + literal);
+			i += literal;
+		}
+	}
+
+	/** decodes n bytes from the code at in into out */
+	inline void decode(const unsigned char* in, unsigned char* out, size_t n) {
+		unsigned char* end = out + n;
+		while (out < end) {
+			const int c = *in++;
+			if (c < 0x80) {
+				std::memcpy(out, in, c + 1);
+				in += c + 1;
+				out += c + 1;
+			}
+			else {
+				std::memset(out, *in++, c - 0x80 + MIN_RUN);
+				out += c - 0x80 + MIN_RUN;
+			}
+		}
+	}
+}
+
+/**
+ * The voxels of a volume, compressed, for volumes which are mostly empty,
+ * e.g. labels and masks. The volume is split into bricks of BRICK^3 voxels.
+ * A brick whose voxels all have the same value is stored as that value only.
+ * The other bricks are stored slice by slice: each BRICK x BRICK slice of
+ * the brick has its values split into byte planes (all low bytes, then the
+ * next bytes, ...), which are compressed with ByteCodec.
+ *
+ * Slices are decompressed on demand into a small cache per thread, so get()
+ * may be called concurrently; loops should visit the volume tile by tile or
+ * brick by brick (see MCCube.SliceCache). set() recompresses the slice, and
+ * must not run concurrently with anything else. Copies share the voxels.
+ */
+template <typename T>
+class CompressedBrickImage {
+public:
+	static const int BRICK = 16;
+	static const int SLICE = BRICK * BRICK;
+	// number of slices cached per thread
+	static const int CACHE = 64;
+
+	int w, h, d;
+
+	CompressedBrickImage() : w(0), h(0), d(0) {}
+
+	/** Compresses the given slices of w x h voxels. */
+	CompressedBrickImage(const T* const* slices, int w, int h, int d)
+		: w(w), h(h), d(d), store(std::make_shared<Store>())
+	{
+		Store& s = *store;
+		s.nbx = (w + BRICK - 1) / BRICK;
+		s.nby = (h + BRICK - 1) / BRICK;
+		const int nbz = (d + BRICK - 1) / BRICK;
+		const size_t nBricks = (size_t)s.nbx * s.nby * nbz;
+		s.constant.assign(nBricks, 1);
+		s.value.assign(nBricks, T());
+		s.slices.resize(nBricks * BRICK);
+
+		std::vector<T> brick((size_t)SLICE * BRICK);
+		for (size_t b = 0; b < nBricks; b++) {
+			const int x0 = (int)(b % s.nbx) * BRICK;
+			const int y0 = (int)(b / s.nbx % s.nby) * BRICK;
+			const int z0 = (int)(b / s.nbx / s.nby) * BRICK;
+			// voxels outside the volume repeat the first one
+			const T first = slices[z0][(size_t)y0 * w + x0];
+			bool constant = true;
+			for (int z = 0; z < BRICK; z++) {
+				for (int y = 0; y < BRICK; y++) {
+					for (int x = 0; x < BRICK; x++) {
+						T v = first;
+						if (x0 + x < w && y0 + y < h && z0 + z < d)
+							v = slices[z0 + z][(size_t)(y0 + y) * w + x0 + x];
+						brick[(size_t)z * SLICE + y * BRICK + x] = v;
+						// bitwise, so that e.g. -0.0f is kept
+						constant = constant && std::memcmp(&v, &first, sizeof(T)) == 0;
+					}
+				}
+			}
+			s.value[b] = first;
+			if (constant) continue;
+			s.constant[b] = 0;
+			for (int z = 0; z < BRICK; z++)
+				encode(brick.data() + (size_t)z * SLICE, s.slices[b * BRICK + z]);
+		}
+	}
+
+	bool empty() const {
+		return store == nullptr;
+	}
+
+	T get(int x, int y, int z) const {
+		const Store& s = *store;
+		const size_t b = brick(x, y, z);
+		if (s.constant[b])
+			return s.value[b];
+		return slice(b * BRICK + z % BRICK)[(y % BRICK) * BRICK + x % BRICK];
+	}
+
+	void set(int x, int y, int z, T v) {
+		Store& s = *store;
+		const size_t b = brick(x, y, z);
+		if (s.constant[b]) {
+			if (v == s.value[b]) return;
+			std::vector<T> plain(SLICE, s.value[b]);
+			for (int i = 0; i < BRICK; i++)
+				encode(plain.data(), s.slices[b * BRICK + i]);
+			s.constant[b] = 0;
+		}
+		const size_t i = b * BRICK + z % BRICK;
+		std::vector<T> plain(slice(i), slice(i) + SLICE);
+		plain[(y % BRICK) * BRICK + x % BRICK] = v;
+		encode(plain.data(), s.slices[i]);
+		// the cached slices of all threads are stale
+		s.generation++;
+	}
+
+	/** the size of the compressed voxels, in bytes */
+	size_t compressedSize() const {
+		const Store& s = *store;
+		size_t size = s.constant.size() * (1 + sizeof(T));
+		for (size_t i = 0; i < s.slices.size(); i++)
+			size += s.slices[i].size();
+		return size;
+	}
+
+private:
+	struct Store {
+		// identifies the store in the caches, unlike its address
+		const uint64_t id;
+		std::atomic<uint64_t> generation;
+		// number of bricks along x and y
+		int nbx, nby;
+		// per brick, whether it is constant, and its value if so
+		std::vector<unsigned char> constant;
+		std::vector<T> value;
+		// per slice of a brick (brick * BRICK + z), its code
+		std::vector<std::vector<unsigned char>> slices;
+
+		Store() : id(nextId()), generation(0), nbx(0), nby(0) {}
+
+		static uint64_t nextId() {
+			static std::atomic<uint64_t> ids(0);
+			return ++ids;
+		}
+	};
+
+	struct CachedSlice {
+		uint64_t id = 0, generation = 0;
+		size_t slice = 0;
+		T values[SLICE];
+	};
+
+	std::shared_ptr<Store> store;
+
+	size_t brick(int x, int y, int z) const {
+		return ((size_t)(z / BRICK) * store->nby + y / BRICK) * store->nbx +
+			x / BRICK;
+	}
+
+	/** the values of slice i, from the cache of the calling thread */
+	const T* slice(size_t i) const {
+		static thread_local CachedSlice cache[CACHE];
+		const Store& s = *store;
+		const uint64_t generation = s.generation;
+		CachedSlice& c = cache[i % CACHE];
+		if (c.id != s.id || c.generation != generation || c.slice != i) {
+			decode(s.slices[i].data(), c.values);
+			c.id = s.id;
+			c.generation = generation;
+			c.slice = i;
+		}
+		return c.values;
+	}
+
+	/** replaces code with the code of the SLICE values */
+	static void encode(const T* values, std::vector<unsigned char>& code) {
+		unsigned char planes[SLICE * sizeof(T)];
+		const unsigned char* bytes = (const unsigned char*)values;
+		for (int i = 0; i < SLICE; i++)
+			for (size_t k = 0; k < sizeof(T); k++)
+				planes[k * SLICE + i] = bytes[i * sizeof(T) + k];
+		code.clear();
+		ByteCodec::encode(planes, sizeof(planes), code);
+		code.shrink_to_fit();
+	}
+
+	static void decode(const unsigned char* code, T* values) {
+		unsigned char planes[SLICE * sizeof(T)];
+		ByteCodec::decode(code, planes, sizeof(planes));
+		unsigned char* bytes = (unsigned char*)values;
+		for (int i = 0; i < SLICE; i++)
+			for (size_t k = 0; k < sizeof(T); k++)
+				bytes[i * sizeof(T) + k] = planes[k * SLICE + i];
+	}
+};
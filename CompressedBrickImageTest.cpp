@@ -0,0 +1,123 @@
+/**
+ * Tests of ByteCodec and CompressedBrickImage: round trips, the token
+ * boundaries of the run length code, and that mostly empty volumes are
+ * stored in a fraction of their size.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "CompressedBrickImage.hpp"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+	if (!ok) {
+		std::printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+static std::vector<unsigned char> encode(const std::vector<unsigned char>& in) {
+	std::vector<unsigned char> code;
+	ByteCodec::encode(in.data(), in.size(), code);
+	return code;
+}
+
+static bool roundTrips(const std::vector<unsigned char>& in) {
+	const std::vector<unsigned char> code = encode(in);
+	std::vector<unsigned char> out(in.size());
+	ByteCodec::decode(code.data(), out.data(), out.size());
+	return out == in;
+}
+
+static void testRoundTrip() {
+	std::srand(1);
+	const size_t lengths[] = { 0, 1, 2, 3, 127, 128, 129, 130, 131, 132, 1000 };
+	for (size_t n : lengths) {
+		std::vector<unsigned char> random(n), constant(n, 7), mixed(n);
+		for (size_t i = 0; i < n; i++) {
+			random[i] = (unsigned char)std::rand();
+			// runs of 1 to 5 equal bytes
+			mixed[i] = (unsigned char)(i / (1 + i % 5) % 3);
+		}
+		check(roundTrips(random), "round trip of random bytes");
+		check(roundTrips(constant), "round trip of equal bytes");
+		check(roundTrips(mixed), "round trip of short runs");
+	}
+}
+
+static void testTokens() {
+	// a run of MAX_RUN bytes is one token
+	std::vector<unsigned char> code = encode(
+		std::vector<unsigned char>(ByteCodec::MAX_RUN, 5));
+	check(code == std::vector<unsigned char>({ 0xff, 5 }), "longest run");
+
+	// one more byte is a literal of its own
+	code = encode(std::vector<unsigned char>(ByteCodec::MAX_RUN + 1, 5));
+	check(code == std::vector<unsigned char>({ 0xff, 5, 0x00, 5 }),
+		"longest run and one byte");
+
+	// MIN_RUN equal bytes are a run, fewer are literal
+	code = encode(std::vector<unsigned char>(ByteCodec::MIN_RUN, 5));
+	check(code == std::vector<unsigned char>({ 0x80, 5 }), "shortest run");
+	code = encode(std::vector<unsigned char>(ByteCodec::MIN_RUN - 1, 5));
+	check(code == std::vector<unsigned char>({ 0x01, 5, 5 }),
+		"too short for a run");
+
+	// a literal ends where a run starts
+	code = encode({ 1, 2, 3, 3, 3 });
+	check(code == std::vector<unsigned char>({ 0x01, 1, 2, 0x80, 3 }),
+		"literal, then run");
+
+	// literals are split after MAX_LITERAL bytes
+	std::vector<unsigned char> distinct(ByteCodec::MAX_LITERAL + 1);
+	for (size_t i = 0; i < distinct.size(); i++)
+		distinct[i] = (unsigned char)i;
+	code = encode(distinct);
+	check(code.size() == distinct.size() + 2 && code[0] == 0x7f &&
+		code[ByteCodec::MAX_LITERAL + 1] == 0x00, "longest literal");
+}
+
+static void testImage() {
+	// a 40 x 35 x 20 mask: zero but for a small box
+	const int w = 40, h = 35, d = 20;
+	std::vector<std::vector<short>> data(d, std::vector<short>(w * h, 0));
+	std::vector<const short*> slices(d);
+	for (int z = 0; z < d; z++) {
+		for (int y = 10; y < 14; y++)
+			for (int x = 30; x < 37; x++)
+				data[z][y * w + x] = (short)(x + y + z);
+		slices[z] = data[z].data();
+	}
+	CompressedBrickImage<short> image(slices.data(), w, h, d);
+	check(!image.empty(), "not empty");
+
+	bool same = true;
+	for (int z = 0; z < d; z++)
+		for (int y = 0; y < h; y++)
+			for (int x = 0; x < w; x++)
+				same = same && image.get(x, y, z) == data[z][y * w + x];
+	check(same, "get() returns the compressed voxels");
+
+	const size_t size = (size_t)w * h * d * sizeof(short);
+	check(image.compressedSize() * 10 < size, "mostly empty volume shrinks");
+
+	// set() in a constant brick and in a compressed one; copies share
+	CompressedBrickImage<short> copy = image;
+	image.set(0, 0, 0, 1000);
+	image.set(33, 11, 5, -3);
+	check(copy.get(0, 0, 0) == 1000 && copy.get(33, 11, 5) == -3,
+		"set() changes the voxel in all copies");
+	check(copy.get(1, 0, 0) == 0 && copy.get(34, 11, 5) == 34 + 11 + 5,
+		"set() keeps the other voxels");
+}
+
+int main() {
+	testRoundTrip();
+	testTokens();
+	testImage();
+	if (failures == 0) std::printf("CompressedBrickImageTest: passed\n");
+	return failures == 0 ? 0 : 1;
+}
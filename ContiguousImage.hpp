@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+/**
+ * The voxels of a volume in a single buffer with constant strides: the voxel
+ * (x, y, z) is at x + y * w + z * w * h, so that its neighbours are at fixed
+ * offsets. The buffer is either owned, in which case it starts on a 64 byte
+ * boundary, or a view of memory owned by someone else, e.g. of the pixels of
+ * an ImageStack whose slices are contiguous already.
+ */
+template <typename T>
+class ContiguousImage {
+public:
+	static const size_t ALIGNMENT = 64;
+
+	int w, h, d;
+	// distance between two slices, in voxels
+	size_t sliceStride;
+	T* data;
+
+	ContiguousImage() : w(0), h(0), d(0), sliceStride(0), data(nullptr) {}
+
+	/** Allocates an aligned buffer for w x h x d voxels. */
+	ContiguousImage(int w, int h, int d) : w(w), h(h), d(d),
+		sliceStride((size_t)w * h), data(nullptr)
+	{
+		const size_t size = ((size_t)w * h * d * sizeof(T) + ALIGNMENT - 1) /
+			ALIGNMENT * ALIGNMENT;
+		if (size == 0) return;
+#if defined(_MSC_VER)
+		void* p = _aligned_malloc(size, ALIGNMENT);
+		buffer.reset((T*)p, [](T* p) { _aligned_free(p); });
+#else
+		void* p = nullptr;
+		if (posix_memalign(&p, ALIGNMENT, size) != 0) p = nullptr;
+		buffer.reset((T*)p, [](T* p) { free(p); });
+#endif
+		if (p == nullptr) throw std::bad_alloc();
+		data = buffer.get();
+	}
+
+	/** Wraps w x h x d voxels at data, without copying them. */
+	static ContiguousImage view(T* data, int w, int h, int d) {
+		ContiguousImage image;
+		image.w = w;
+		image.h = h;
+		image.d = d;
+		image.sliceStride = (size_t)w * h;
+		image.data = data;
+		return image;
+	}
+
+	/**
+	 * Returns a view of the given slices of w x h pixels if they follow each
+	 * other in memory, a copy of them if copy is true, and an empty image
+	 * otherwise.
+	 */
+	static ContiguousImage fromSlices(T* const* slices, int w, int h, int d,
+		bool copy)
+	{
+		const size_t n = (size_t)w * h;
+		bool contiguous = d > 0;
+		for (int z = 1; z < d && contiguous; z++)
+			contiguous = slices[z] == slices[0] + z * n;
+		if (contiguous)
+			return view(slices[0], w, h, d);
+		if (!copy)
+			return ContiguousImage();
+		ContiguousImage image(w, h, d);
+		for (int z = 0; z < d; z++)
+			std::memcpy(image.data + z * n, slices[z], n * sizeof(T));
+		return image;
+	}
+
+	bool empty() const {
+		return data == nullptr;
+	}
+
+	/** true if the voxels are owned by someone else */
+	bool isView() const {
+		return data != nullptr && buffer == nullptr;
+	}
+
+	size_t index(int x, int y, int z) const {
+		return z * sliceStride + (size_t)y * w + x;
+	}
+
+	T get(int x, int y, int z) const {
+		return data[index(x, y, z)];
+	}
+
+	void set(int x, int y, int z, T v) {
+		data[index(x, y, z)] = v;
+	}
+
+	/** the slice z, w * h voxels at y * w + x */
+	T* slice(int z) const {
+		return data + z * sliceStride;
+	}
+
+private:
+	std::shared_ptr<T> buffer;
+};
@@ -60,6 +60,29 @@ public class CustomTriangleMesh extends CustomMesh {
 		}
 	}
 
+	/**
+	 * Creates a mesh from indexed triangles, as returned by
+	 * MCCube.getIndexedTriangles(). The mass properties are computed on the
+	 * shared vertices; the base class still stores a triangle list.
+	 */
+	public CustomTriangleMesh(final List<Point3f> vertices, final int[] indices,
+		final Color3f col, final float trans)
+	{
+		super(expand(vertices, indices), col, trans);
+		final Point3d center = new Point3d();
+		final double[][] inertia = new double[3][3];
+		volume = MeshProperties.compute(vertices, indices, center, inertia);
+	}
+
+	private static List<Point3f> expand(final List<Point3f> vertices,
+		final int[] indices)
+	{
+		final List<Point3f> mesh = new ArrayList<Point3f>(indices.length);
+		for (final int i : indices)
+			mesh.add(vertices.get(i));
+		return mesh;
+	}
+
 	public void setMesh(final List<Point3f> mesh) {
 		this.mesh = mesh;
 		update();
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Downsamples a volume by 2, 4, 8, ... in a single pass over its slices.
+ * Each voxel of a level is the mean of the source voxels it covers, fewer at
+ * the upper borders, truncated, as with BoxResampler. All levels are summed
+ * from the source slices, rather than each from the level below it, whose
+ * truncated means of means would differ. Slices are fed in z order with
+ * addSlice(); a slice of a level is complete as soon as the last of its
+ * source slices was added.
+ *
+ * The voxel (x, y, z) of level k covers the source voxels (x, y, z) * 2^(k+1)
+ * to (x, y, z) * 2^(k+1) + 2^(k+1) - 1, the layout of NaiveResampler.
+ */
+class DownsamplingCascade {
+public:
+	struct Level {
+		int w, h, d;
+		std::vector<int> values;
+
+		/** the intensity of the voxel (x, y, z), which must be in bounds */
+		int intensity(int x, int y, int z) const {
+			return values[((size_t)z * h + y) * w + x];
+		}
+	};
+
+	// levels[k] is downsampled by 2^(k+1)
+	std::vector<Level> levels;
+
+	/**
+	 * @param w
+	 * @param h
+	 * @param d dimensions of the source volume
+	 * @param nLevels number of downsampled levels
+	 */
+	DownsamplingCascade(int w, int h, int d, int nLevels) : w(w), h(h), d(d) {
+		for (int k = 0; k < nLevels; k++) {
+			const int f = 2 << k;
+			Level l;
+			l.w = (w + f - 1) / f;
+			l.h = (h + f - 1) / f;
+			l.d = (d + f - 1) / f;
+			l.values.assign((size_t)l.w * l.h * l.d, 0);
+			levels.push_back(l);
+		}
+		sums.resize(levels.size());
+		counts.resize(levels.size());
+		for (size_t k = 0; k < levels.size(); k++) {
+			sums[k].assign((size_t)levels[k].w * levels[k].h, 0);
+			counts[k].assign((size_t)levels[k].w * levels[k].h, 0);
+		}
+	}
+
+	/**
+	 * Adds the slice z of the source, w * h intensities at y * w + x. The
+	 * slices must be added in increasing z order.
+	 */
+	void addSlice(int z, const int* values) {
+		for (size_t k = 0; k < levels.size(); k++)
+			add(k, z, values);
+	}
+
+private:
+	// dimensions of the source
+	int w, h, d;
+
+	// per level, the sums and counts of the slice being accumulated
+	std::vector<std::vector<long long>> sums;
+	std::vector<std::vector<int>> counts;
+
+	/** adds the slice z of the source to level k */
+	void add(size_t k, int z, const int* values) {
+		const int shift = (int)k + 1;
+		Level& l = levels[k];
+		long long* s = sums[k].data();
+		int* c = counts[k].data();
+		for (int y = 0; y < h; y++) {
+			const int* row = values + (size_t)y * w;
+			const size_t i = (size_t)(y >> shift) * l.w;
+			for (int x = 0; x < w; x++) {
+				s[i + (x >> shift)] += row[x];
+				c[i + (x >> shift)]++;
+			}
+		}
+		if (((z + 1) >> shift) << shift != z + 1 && z + 1 < d)
+			return;
+
+		// the slice z >> shift of this level is complete
+		int* out = l.values.data() + (size_t)(z >> shift) * l.w * l.h;
+		for (size_t i = 0; i < sums[k].size(); i++) {
+			out[i] = c[i] == 0 ? 0 : (int)(s[i] / c[i]);
+			s[i] = 0;
+			c[i] = 0;
+		}
+	}
+};
@@ -0,0 +1,419 @@
+#include "thirdparties/include/glm/vec3.hpp"
+#include <algorithm>
+#include <climits>
+#include <thread>
+#include <vector>
+
+#include "Carrier.hpp"
+#include "MCTables.hpp"
+
+using namespace glm;
+
+/**
+ * Isosurface extraction with the flying edges algorithm (Schroeder, Maynard
+ * and Geveci, 2015), producing the same triangles as MCCube from the same
+ * lookup table.
+ *
+ * The volume is processed in independent rows along x, layer of cubes by
+ * layer of cubes; each thread only holds the two vertex layers of its
+ * current layer of cubes:
+ * 1. classify the x-edges of every vertex row and record the range of edges
+ *    crossing the isovalue (the trim bounds),
+ * 2. count the triangles of every row of cubes, looking only at the cubes
+ *    within the trim bounds of its four vertex rows,
+ * 3. prefix sum the counts, which gives the exact size of the output and
+ *    the offset of every row in it,
+ * 4. classify the vertex rows again and generate the triangles of every row
+ *    of cubes at its offset. The points on the crossing x-, y- and z-edges
+ *    are computed once per row, and the cubes pick theirs from there.
+ * Passes 1 and 2 run together; they and pass 4 run in parallel without any
+ * locking.
+ */
+class FlyingEdges {
+
+	/** the state of the sweep, shared by all passes */
+	struct Grid {
+		Carrier car;
+		// number of vertexes along each axis, including the padding
+		int nx, ny, nz;
+		// per cube row: the trim bounds and the triangle offset
+		std::vector<int> cl, cr;
+		std::vector<size_t> offsets;
+	};
+
+	/**
+	 * The vertex layers z and z + 1 of the layer of cubes z, in padded
+	 * coordinates. Per layer: the intensities, the classification of the
+	 * nx - 1 x-edges of every row (bit 0 is set if the left vertex is above
+	 * the threshold, bit 1 if the right one is), and the first and one past
+	 * the last crossing x-edge of every row.
+	 */
+	struct Layers {
+		int z;
+		std::vector<int> values[2];
+		std::vector<unsigned char> edgeCases[2];
+		std::vector<int> xl[2], xr[2];
+
+		Layers(const Grid& g) : z(INT_MIN) {
+			for (int l = 0; l < 2; l++) {
+				values[l].resize((size_t)g.nx * g.ny);
+				edgeCases[l].resize((size_t)(g.nx - 1) * g.ny);
+				xl[l].resize(g.ny);
+				xr[l].resize(g.ny);
+			}
+		}
+
+		/** makes these the layers of the layer of cubes z */
+		void advance(const Grid& g, Carrier& car, int z) {
+			if (z == this->z + 1) {
+				std::swap(values[0], values[1]);
+				std::swap(edgeCases[0], edgeCases[1]);
+				std::swap(xl[0], xl[1]);
+				std::swap(xr[0], xr[1]);
+			}
+			else {
+				classifyLayer(g, car, z, 0);
+			}
+			classifyLayer(g, car, z + 1, 1);
+			this->z = z;
+		}
+
+		/** Pass 1: reads and classifies the vertex layer z into layer l */
+		void classifyLayer(const Grid& g, Carrier& car, int z, int l) {
+			for (int y = 0; y < g.ny; y++) {
+				int* val = value(g, l, y);
+				unsigned char* ec = &edgeCases[l][(size_t)y * (g.nx - 1)];
+				for (int i = 0; i < g.nx; i++)
+					val[i] = car.intensity(vec3(i - 1, y - 1, z - 1));
+				int first = g.nx - 1, last = 0;
+				int left = above(car, val[0]);
+				for (int i = 0; i < g.nx - 1; i++) {
+					const int right = above(car, val[i + 1]);
+					ec[i] = (unsigned char)(left | right << 1);
+					if (left != right) {
+						first = std::min(first, i);
+						last = i + 1;
+					}
+					left = right;
+				}
+				xl[l][y] = first;
+				xr[l][y] = last;
+			}
+		}
+
+		/** the x-edges of the row y of layer l */
+		const unsigned char* row(const Grid& g, int l, int y) const {
+			return &edgeCases[l][(size_t)y * (g.nx - 1)];
+		}
+
+		/** the intensities of the row y of layer l */
+		int* value(const Grid& g, int l, int y) {
+			return &values[l][(size_t)y * g.nx];
+		}
+	};
+
+	/**
+	 * The points on the crossing edges of the current rows of cubes; the
+	 * points of the other edges are undefined. The x-edges (both layers)
+	 * and the z-edges of the vertex row y are kept in slot y & 1, where the
+	 * next row of cubes finds them; the y-edges (both layers) are the ones
+	 * of the current row of cubes.
+	 */
+	struct Edges {
+		// the vertex row in each slot, for the current layer of cubes
+		int rows[2];
+		std::vector<vec3> xEdges[2][2], zEdges[2];
+		std::vector<vec3> yEdges[2];
+
+		Edges(const Grid& g) {
+			for (int s = 0; s < 2; s++) {
+				rows[s] = INT_MIN;
+				xEdges[s][0].resize(g.nx - 1);
+				xEdges[s][1].resize(g.nx - 1);
+				zEdges[s].resize(g.nx);
+				yEdges[s].resize(g.nx);
+			}
+		}
+	};
+
+	/**
+	 * Create a list of triangles from the specified image data and the given
+	 * isovalue. The triangles are the ones of MCCube.getTriangles(), but the
+	 * order differs.
+	 *
+	 * @param volume
+	 * @param thresh
+	 * @param nThreads number of worker threads; if <= 0, one per hardware
+	 *          thread is used
+	 * @return
+	 */
+public:
+	static std::vector<vec3> getTriangles(
+		//Volume volume,
+		int volume,
+		int thresh,
+		int nThreads = 0)
+	{
+		Grid g;
+		//g.car.w = volume.xDim;
+		//g.car.h = volume.yDim;
+		//g.car.d = volume.zDim;
+		g.car.w = volume;
+		g.car.h = volume;
+		g.car.d = volume;
+		g.car.threshold = thresh + 0.5f;
+		g.car.volume = volume;
+
+		// like MCCube, vertexes run from -1 to w + 1 (zero outside the image)
+		g.nx = g.car.w + 3;
+		g.ny = g.car.h + 3;
+		g.nz = g.car.d + 3;
+		if (nThreads <= 0)
+			nThreads = (int)std::thread::hardware_concurrency();
+		nThreads = std::max(1, std::min(nThreads, g.nz - 1));
+
+		const size_t nCubeRows = (size_t)(g.ny - 1) * (g.nz - 1);
+		g.cl.resize(nCubeRows);
+		g.cr.resize(nCubeRows);
+		g.offsets.resize(nCubeRows + 1);
+
+		forEachSlab(g.nz - 1, nThreads, [&g](int z0, int z1) {
+			Carrier car = g.car;
+			Layers layers(g);
+			for (int z = z0; z < z1; z++) {
+				layers.advance(g, car, z);
+				for (int y = 0; y < g.ny - 1; y++)
+					countRow(g, layers, y, z);
+			}
+		});
+
+		// turn the counts into offsets
+		size_t total = 0;
+		for (size_t row = 0; row < nCubeRows; row++) {
+			const size_t n = g.offsets[row];
+			g.offsets[row] = total;
+			total += n;
+		}
+		g.offsets[nCubeRows] = total;
+
+		std::vector<vec3> tri(3 * total);
+		forEachSlab(g.nz - 1, nThreads, [&g, &tri](int z0, int z1) {
+			Carrier car = g.car;
+			Layers layers(g);
+			Edges edges(g);
+			for (int z = z0; z < z1; z++) {
+				// layers without triangles are not read again
+				const size_t row = (size_t)z * (g.ny - 1);
+				if (g.offsets[row] == g.offsets[row + g.ny - 1])
+					continue;
+				layers.advance(g, car, z);
+				edges.rows[0] = edges.rows[1] = INT_MIN;
+				for (int y = 0; y < g.ny - 1; y++)
+					generateRow(g, layers, edges, y, z, tri.data());
+			}
+		});
+
+		// convert pixel coordinates
+		for (size_t i = 0; i < tri.size(); i++) {
+			vec3& p = tri[i];
+			//p.x = (float)(p.x * volume.pw + volume.minCoord.x);
+			//p.y = (float)(p.y * volume.ph + volume.minCoord.y);
+			//p.z = (float)(p.z * volume.pd + volume.minCoord.z);
+			p.x = (float)(p.x * volume + volume);
+			p.y = (float)(p.y * volume + volume);
+			p.z = (float)(p.z * volume + volume);
+		}
+		return tri;
+	}
+
+	/**
+	 * Pass 2: computes the trim bounds and the number of triangles of the row
+	 * of cubes (y, z), given in padded coordinates.
+	 */
+private:
+	static void countRow(Grid& g, const Layers& layers, int y, int z) {
+		const size_t row = (size_t)z * (g.ny - 1) + y;
+		const unsigned char* ec[4];
+		ec[0] = layers.row(g, 0, y);
+		ec[1] = layers.row(g, 0, y + 1);
+		ec[2] = layers.row(g, 1, y);
+		ec[3] = layers.row(g, 1, y + 1);
+		int cl = g.nx - 1, cr = 0;
+		for (int k = 0; k < 4; k++) {
+			cl = std::min(cl, layers.xl[k / 2][y + k % 2]);
+			cr = std::max(cr, layers.xr[k / 2][y + k % 2]);
+		}
+		// left and right of the trim bounds, all four vertex rows are
+		// constant, and equal to their padded vertexes 0 and nx - 1, which
+		// are zero in every row: no y- or z-edge crosses there either
+
+		size_t n = 0;
+		for (int i = cl; i < cr; i++)
+			n += triangleCount(caseNumber(ec, i));
+		g.cl[row] = cl;
+		g.cr[row] = cr;
+		g.offsets[row] = n;
+	}
+
+	/**
+	 * Pass 4: writes the triangles of the row of cubes (y, z), given in
+	 * padded coordinates, to its offset in tri.
+	 */
+private:
+	static void generateRow(Grid& g, Layers& layers, Edges& edges, int y,
+		int z, vec3* tri)
+	{
+		const size_t row = (size_t)z * (g.ny - 1) + y;
+		if (g.offsets[row] == g.offsets[row + 1])
+			return;
+		const int cl = g.cl[row], cr = g.cr[row];
+		const unsigned char* ec[4];
+		ec[0] = layers.row(g, 0, y);
+		ec[1] = layers.row(g, 0, y + 1);
+		ec[2] = layers.row(g, 1, y);
+		ec[3] = layers.row(g, 1, y + 1);
+
+		computeRowEdges(g, layers, edges, y, z);
+		computeRowEdges(g, layers, edges, y + 1, z);
+		// the y-edges of the vertexes cl to cr
+		for (int l = 0; l < 2; l++) {
+			const int* v0 = layers.value(g, l, y);
+			const int* v1 = layers.value(g, l, y + 1);
+			const unsigned char* a0 = ec[2 * l];
+			const unsigned char* a1 = ec[2 * l + 1];
+			vec3* out = edges.yEdges[l].data();
+			for (int i = cl; i <= cr; i++) {
+				if (above(a0, i, g.nx) == above(a1, i, g.nx)) continue;
+				out[i] = computeEdge(vec3(i - 1, y - 1, z - 1 + l), v0[i],
+					vec3(i - 1, y, z - 1 + l), v1[i], g.car.threshold);
+			}
+		}
+
+		// the edges of cube i, in the order of MCCube: the x-edges 0, 2, 4
+		// and 6, the y-edges 1, 3, 5 and 7, and the z-edges 8 to 11
+		const int s0 = y & 1, s1 = (y + 1) & 1;
+		const vec3* x00 = edges.xEdges[s0][0].data();
+		const vec3* x10 = edges.xEdges[s1][0].data();
+		const vec3* x01 = edges.xEdges[s0][1].data();
+		const vec3* x11 = edges.xEdges[s1][1].data();
+		const vec3* y0 = edges.yEdges[0].data();
+		const vec3* y1 = edges.yEdges[1].data();
+		const vec3* z0 = edges.zEdges[s0].data();
+		const vec3* z1 = edges.zEdges[s1].data();
+
+		vec3* out = tri + 3 * g.offsets[row];
+		const vec3* e[12];
+		for (int i = cl; i < cr; i++) {
+			const int cn = caseNumber(ec, i);
+			if (triangleCount(cn) == 0)
+				continue;
+			e[0] = x00 + i;
+			e[1] = y0 + i + 1;
+			e[2] = x10 + i;
+			e[3] = y0 + i;
+			e[4] = x01 + i;
+			e[5] = y1 + i + 1;
+			e[6] = x11 + i;
+			e[7] = y1 + i;
+			e[8] = z0 + i;
+			e[9] = z0 + i + 1;
+			e[10] = z1 + i;
+			e[11] = z1 + i + 1;
+			const MCTables::Case& c = MCTables::caseTable[cn];
+			for (int index = 0; index < 3 * c.count; index++)
+				*out++ = *e[c.edges[index]];
+		}
+	}
+
+	/**
+	 * Computes the points on the crossing x-edges (both layers) and z-edges
+	 * of the vertex row y into its slot, unless they are there already.
+	 */
+private:
+	static void computeRowEdges(Grid& g, Layers& layers, Edges& edges, int y,
+		int z)
+	{
+		const int s = y & 1;
+		if (edges.rows[s] == y) return;
+		edges.rows[s] = y;
+		const float t = g.car.threshold;
+		for (int l = 0; l < 2; l++) {
+			const int* v = layers.value(g, l, y);
+			const unsigned char* ec = layers.row(g, l, y);
+			vec3* out = edges.xEdges[s][l].data();
+			for (int i = layers.xl[l][y]; i < layers.xr[l][y]; i++) {
+				if ((ec[i] & 1) == (ec[i] >> 1)) continue;
+				out[i] = computeEdge(vec3(i - 1, y - 1, z - 1 + l), v[i],
+					vec3(i, y - 1, z - 1 + l), v[i + 1], t);
+			}
+		}
+		const int* v0 = layers.value(g, 0, y);
+		const int* v1 = layers.value(g, 1, y);
+		const unsigned char* a0 = layers.row(g, 0, y);
+		const unsigned char* a1 = layers.row(g, 1, y);
+		vec3* out = edges.zEdges[s].data();
+		for (int i = 0; i < g.nx; i++) {
+			if (above(a0, i, g.nx) == above(a1, i, g.nx)) continue;
+			out[i] = computeEdge(vec3(i - 1, y - 1, z - 1), v0[i],
+				vec3(i - 1, y - 1, z), v1[i], t);
+		}
+	}
+
+	/**
+	 * the interpolated point on the edge v1-v2; the same computation as
+	 * MCCube.computeEdge(), so that the vertexes are identical
+	 */
+private:
+	static vec3 computeEdge(vec3 v1, int i1, vec3 v2, int i2, float threshold) {
+		if (i2 < i1)
+			return computeEdge(v2, i2, v1, i1, threshold);
+		float t = (threshold - i1) / (i2 - i1);
+		vec3 result = v2;
+		result -= v1;
+		result *= t;
+		result += v1;
+		return result;
+	}
+
+	/** the case number of cube i, given the x-edges of its four rows */
+private:
+	static int caseNumber(const unsigned char* const* ec, int i) {
+		const int e0 = ec[0][i], e1 = ec[1][i], e2 = ec[2][i], e3 = ec[3][i];
+		return e0 | (e1 & 2) << 1 | (e1 & 1) << 3 | e2 << 4 |
+			(e3 & 2) << 5 | (e3 & 1) << 7;
+	}
+
+	/** the number of triangles of a case */
+private:
+	static int triangleCount(int cn) {
+		return MCTables::caseTable[cn].count;
+	}
+
+private:
+	static int above(const Carrier& car, int intensity) {
+		return intensity - car.threshold > 0 ? 1 : 0;
+	}
+
+	/** whether the vertex i of a row of nx vertexes, given its x-edges, is above */
+private:
+	static int above(const unsigned char* ec, int i, int nx) {
+		return i < nx - 1 ? ec[i] & 1 : ec[nx - 2] >> 1;
+	}
+
+	/**
+	 * calls f(begin, end) for nThreads consecutive parts of [0, n), each on
+	 * its own thread
+	 */
+private:
+	template <typename F>
+	static void forEachSlab(int n, int nThreads, F f) {
+		std::vector<std::thread> workers;
+		for (int i = 0; i < nThreads; i++) {
+			const int begin = (int)((long long)n * i / nThreads);
+			const int end = (int)((long long)n * (i + 1) / nThreads);
+			workers.push_back(std::thread(f, begin, end));
+		}
+		for (size_t i = 0; i < workers.size(); i++)
+			workers[i].join();
+	}
+};
@@ -0,0 +1,91 @@
+/**
+ * Tests of FlyingEdges against MCCube: both give the same triangles, in a
+ * different order, which are compared sorted. The volume is N x N x N
+ * voxels read by the Carrier::intensity() defined here: a blurred sphere
+ * with some spikes, and planes which cut the volume up to its faces, where
+ * the trim bounds of the rows reach the padding.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "thirdparties/include/glm/vec3.hpp"
+#include "Carrier.hpp"
+
+// odd, so that no row of cubes is a multiple of a vector width
+static const int N = 23;
+static std::vector<int> voxels;
+
+int Carrier::intensity(glm::vec3 p) const {
+	if (p.x < 0 || p.y < 0 || p.z < 0 || p.x >= w || p.y >= h || p.z >= d)
+		return 0;
+	return voxels[((int)p.z * N + (int)p.y) * N + (int)p.x];
+}
+
+#include "MCCube.cpp"
+#include "FlyingEdges.cpp"
+
+static int failures = 0;
+
+/** reports a failure of what, for the threshold t and n threads */
+static void check(bool ok, const char* what, int t, int n) {
+	if (!ok) {
+		std::printf("FAILED: %s (threshold %d, %d threads)\n", what, t, n);
+		failures++;
+	}
+}
+
+/** the triangles as sorted tuples of their three points */
+static std::vector<std::array<float, 9>> sorted(const std::vector<vec3>& tri) {
+	std::vector<std::array<float, 9>> out(tri.size() / 3);
+	for (size_t i = 0; i < out.size(); i++)
+		for (int k = 0; k < 3; k++) {
+			out[i][3 * k] = tri[3 * i + k].x;
+			out[i][3 * k + 1] = tri[3 * i + k].y;
+			out[i][3 * k + 2] = tri[3 * i + k].z;
+		}
+	std::sort(out.begin(), out.end());
+	return out;
+}
+
+static void compare(int thresh) {
+	const std::vector<std::array<float, 9>> expected =
+		sorted(MCCube::getTriangles(N, thresh));
+	const int threads[] = { 1, 3, 0 };
+	for (int n : threads) {
+		const std::vector<vec3> tri = FlyingEdges::getTriangles(N, thresh, n);
+		check(tri.size() % 3 == 0, "whole triangles", thresh, n);
+		check(sorted(tri) == expected, "the triangles of MCCube", thresh, n);
+	}
+}
+
+int main() {
+	const int thresholds[] = { -5, 0, 50, 100, 200, 254, 300 };
+
+	voxels.resize((size_t)N * N * N);
+	for (int z = 0; z < N; z++)
+		for (int y = 0; y < N; y++)
+			for (int x = 0; x < N; x++) {
+				const float dx = x - 10.5f, dy = y - 9.0f, dz = z - 7.0f;
+				const float r = std::sqrt(dx * dx + dy * dy + dz * dz);
+				voxels[((size_t)z * N + y) * N + x] = (int)std::fmax(0.f,
+					255 - 20 * r) + ((x * 7 + y * 3 + z) % 5 == 0 ? 60 : 0);
+			}
+	for (int t : thresholds)
+		compare(t);
+
+	// planes across the whole volume: every row crosses at the faces only
+	for (int z = 0; z < N; z++)
+		for (int y = 0; y < N; y++)
+			for (int x = 0; x < N; x++)
+				voxels[((size_t)z * N + y) * N + x] =
+					(y < 7 ? 200 : 0) + (z > 12 ? 100 : 0);
+	for (int t : thresholds)
+		compare(t);
+
+	if (failures == 0) std::printf("FlyingEdgesTest: passed\n");
+	return failures == 0 ? 0 : 1;
+}
@@ -21,14 +21,39 @@
  */
 
 #include "thirdparties/include/glm/vec3.hpp"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
+#if defined(__AVX2__)
+#define MC_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MC_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #include "Carrier.hpp"
+#include "DownsamplingCascade.hpp"
+#include "MCTables.hpp"
+#include "MinMaxPyramid.hpp"
 
 using namespace glm;
 
 class MCCube {
 
+	friend class TriangulationContext;
+	friend class MCCubeTest;
 	
 private:
 	// vertexes
@@ -72,8 +97,9 @@ public:
 	 * @return false if the interpolated point is beyond edge boundaries
 	 */
 private: 
-	bool computeEdge(vec3 v1, int i1, vec3 v2,
-		int i2, vec3 result,  Carrier car)
+	template <typename V>
+	bool computeEdge(vec3 v1, V i1, vec3 v2,
+		V i2, vec3& result, Carrier& car)
 	{
 		// 30 --- 50 --- 70 : t=0.5
 		// 70 --- 50 --- 30 : t=0.5
@@ -88,7 +114,7 @@ private:
 			// v1 + t*(v2-v1)
 			result = v2;
 			result -= v1;
-			result /= t;
+			result *= t;
 			result += v1;
 			return true;
 		}
@@ -101,16 +127,23 @@ private:
 	 * interpolated value doesn't belong to the edge)
 	 */
 private: 
-	void computeEdges(Carrier car) {
-		int i0 = car.intensity(v[0]);
-		int i1 = car.intensity(v[1]);
-		int i2 = car.intensity(v[2]);
-		int i3 = car.intensity(v[3]);
-		int i4 = car.intensity(v[4]);
-		int i5 = car.intensity(v[5]);
-		int i6 = car.intensity(v[6]);
-		int i7 = car.intensity(v[7]);
-		
+	void computeEdges(Carrier& car) {
+		int i[8];
+		for (int index = 0; index < 8; index++)
+			i[index] = car.intensity(v[index]);
+		computeEdges(i, car);
+	}
+
+	/**
+	 * same as computeEdges(car), with the intensities at the vertexes given,
+	 * as int or as float
+	 */
+private:
+	template <typename V>
+	void computeEdges(const V* i, Carrier& car) {
+		const V i0 = i[0], i1 = i[1], i2 = i[2], i3 = i[3];
+		const V i4 = i[4], i5 = i[5], i6 = i[6], i7 = i[7];
+
 		this->computeEdge(v[0], i0, v[1], i1, e[0], car);
 		this->computeEdge(v[1], i1, v[2], i2, e[1], car);
 		this->computeEdge(v[2], i2, v[3], i3, e[2], car);
@@ -135,30 +168,486 @@ private:
 	 */
 private:
 	bool isAmbigous(int n) {
-		bool result = false;
-		for (int index = 0; index < sizeof(ambigous); index++) {
-			result |= ambigous[index] == n;
-		}
-		return result;
+		return MCTables::ambigousCases.contains(n);
+	}
+
+private:
+	void getTriangles(std::vector<vec3>& list, Carrier& car) {
+		getTriangles(list, caseNumber(car));
 	}
 
 private:
-	void getTriangles(std::vector<vec3> list, Carrier car) {
-		int cn = caseNumber(car);
+	void getTriangles(std::vector<vec3>& list, int cn) {
 		bool directTable = !(isAmbigous(cn));
 		directTable = true;
 
-		// address in the table
-		int offset = directTable ? cn * 15 : (255 - cn) * 15;
-		for (int index = 0; index < 5; index++) {
-			// if there's a triangle
-			if (faces[offset] != -1) {
-				// pick up vertexes of the current triangle
-				list.push_back(vec3(this->e[faces[offset + 0]]));
-				list.push_back(vec3(this->e[faces[offset + 1]]));
-				list.push_back(vec3(this->e[faces[offset + 2]]));
+		// the triangles of the case
+		const MCTables::Case& c = MCTables::caseTable[directTable ? cn : 255 - cn];
+		for (int index = 0; index < 3 * c.count; index += 3) {
+			// pick up vertexes of the current triangle
+			list.push_back(vec3(this->e[c.edges[index + 0]]));
+			list.push_back(vec3(this->e[c.edges[index + 1]]));
+			list.push_back(vec3(this->e[c.edges[index + 2]]));
+		}
+	}
+
+	/** writes the triangles of case cn to out and returns the end */
+private:
+	vec3* getTriangles(vec3* out, int cn) {
+		const MCTables::Case& c = MCTables::caseTable[cn];
+		for (int index = 0; index < 3 * c.count; index++)
+			*out++ = this->e[c.edges[index]];
+		return out;
+	}
+
+	/**
+	 * Caches the intensities of the two vertex layers z and z + 1 touched by
+	 * one layer of cubes, so that a sweep loads and compares each voxel only
+	 * once. Each layer is stored x-major (the sweep runs along y) with a zero
+	 * border covering the vertexes from -1 to w + 1 and -1 to h + 1.
+	 *
+	 * The cache classifies the cubes against one or several isovalues. After
+	 * startLayer(), the cases of each isovalue hold the case number of every
+	 * cube of the layer and its active list the (layer) indices of the cubes
+	 * whose case is neither 0 nor 255, in sweep order. Both the threshold
+	 * comparison and the case numbers are computed for whole rows at a time
+	 * with SSE2/AVX2; the layers are compared against all isovalues block by
+	 * block, while the block is still in the cache.
+	 *
+	 * If the Carrier has a min/max pyramid, only the voxels and cubes of the
+	 * bricks straddling some isovalue are loaded and classified, and
+	 * startLayer() returns false for layers without any such brick.
+	 *
+	 * The intensities are of type V, int or float; 16 bit data fits into
+	 * int, float data is compared and interpolated as it is.
+	 */
+	template <typename V>
+	struct BasicSliceCache {
+		// slack after each buffer, so that vector loads may run over the end
+		static const int PADDING = 64;
+		// number of intensities compared against all isovalues at a time
+		static const int BLOCK = 4096;
+		// edge length of the tiles a layer is read in, the default brick
+		// size; tiles are 2D, within one layer
+		static const int TILE = 16;
+
+		/** the classification of the cubes against one isovalue */
+		struct Isovalue {
+			float threshold;
+			// v - threshold > 0 <=> v > t; for int, t = floor(threshold)
+			V t;
+			// whether the intensities are above the threshold
+			std::vector<unsigned char> above[2];
+			// case numbers of the current layer, and the cubes having triangles
+			std::vector<unsigned char> cases;
+			std::vector<int> active;
+		};
+
+		// dimensions of a padded layer
+		int w, h;
+		// z of the lower layer
+		int z;
+		// intensities
+		std::vector<V> values[2];
+		std::vector<Isovalue> isovalues;
+		// bricks of the current brick layer straddling some isovalue
+		const MinMaxPyramid* pyramid;
+		float lo, hi;
+		int brickLayer;
+		int nBricks;
+		std::vector<unsigned char> bricks;
+
+		BasicSliceCache(const Carrier& car) : BasicSliceCache(car,
+			std::vector<float>(1, car.threshold)) {}
+
+		BasicSliceCache(const Carrier& car, const std::vector<float>& thresholds)
+			: w(car.w + 3), h(car.h + 3), z(INT_MIN), isovalues(thresholds.size()),
+			pyramid(car.pyramid), lo(0), hi(0), brickLayer(INT_MIN), nBricks(0)
+		{
+			const size_t size = (size_t)w * h + PADDING;
+			for (int i = 0; i < 2; i++)
+				values[i].assign(size, 0);
+			for (size_t k = 0; k < thresholds.size(); k++) {
+				Isovalue& iso = isovalues[k];
+				iso.threshold = thresholds[k];
+				comparand(iso.threshold, iso.t);
+				for (int i = 0; i < 2; i++)
+					iso.above[i].assign(size, 0);
+				iso.cases.assign(size, 0);
+			}
+			if (!thresholds.empty()) {
+				lo = *std::min_element(thresholds.begin(), thresholds.end());
+				hi = *std::max_element(thresholds.begin(), thresholds.end());
+			}
+		}
+
+		/** the t of an isovalue, see Isovalue */
+		static void comparand(float threshold, int& t) {
+			const double f = std::floor((double)threshold);
+			t = f < INT_MIN ? INT_MIN : f > INT_MAX ? INT_MAX : (int)f;
+		}
+
+		static void comparand(float threshold, float& t) {
+			t = threshold;
+		}
+
+		/** index of the vertex (x, y) in a layer */
+		int index(int x, int y) const {
+			return (x + 1) * h + (y + 1);
+		}
+
+		/**
+		 * Called before the cubes of layer z are processed. Returns false if
+		 * the layer has no triangles.
+		 */
+		bool startLayer(Carrier& car, int z) {
+			return startLayer(car, z, [&car](int x, int y, int z) {
+				return car.intensity(vec3(x, y, z));
+			});
+		}
+
+		/**
+		 * Like startLayer(car, z), but reads the intensities of the in-bounds
+		 * voxels with intensity(x, y, z) instead of the Carrier.
+		 */
+		template <typename Intensity>
+		bool startLayer(Carrier& car, int z, Intensity intensity) {
+			if (pyramid != nullptr) {
+				const int bz = (z + 1) / pyramid->brickSize;
+				if (bz != brickLayer) {
+					brickLayer = bz;
+					nBricks = pyramid->activeBricks(bz, lo, hi, bricks);
+					// only the bricks of the previous brick layer were loaded
+					this->z = INT_MIN;
+				}
+				if (nBricks == 0) {
+					for (size_t k = 0; k < isovalues.size(); k++)
+						isovalues[k].active.clear();
+					return false;
+				}
+			}
+			if (z == this->z + 1) {
+				std::swap(values[0], values[1]);
+				for (size_t k = 0; k < isovalues.size(); k++)
+					std::swap(isovalues[k].above[0], isovalues[k].above[1]);
+			}
+			else {
+				load(car, z, 0, intensity);
+			}
+			load(car, z + 1, 1, intensity);
+			this->z = z;
+			classify();
+			return true;
+		}
+
+		template <typename Intensity>
+		void load(Carrier& car, int z, int layer, Intensity& intensity) {
+			V* val = values[layer].data();
+			if (z < 0 || z >= car.d) {
+				std::fill(val, val + (size_t)w * h, 0);
+			}
+			else if (pyramid != nullptr) {
+				// the vertexes of the active bricks
+				const int b = pyramid->brickSize;
+				const int nx = pyramid->levels[0].nx;
+				for (int by = 0; by < pyramid->levels[0].ny; by++) {
+					for (int bx = 0; bx < nx; bx++) {
+						if (!bricks[by * nx + bx]) continue;
+						const int x1 = std::min(bx * b + b - 1, car.w - 1);
+						const int y1 = std::min(by * b + b - 1, car.h - 1);
+						for (int y = std::max(by * b - 1, 0); y <= y1; y++) {
+							for (int x = std::max(bx * b - 1, 0); x <= x1; x++)
+								val[index(x, y)] = intensity(x, y, z);
+						}
+					}
+				}
+			}
+			else {
+				// the border stays zero; it is never written. The layer is
+				// read in TILE x TILE tiles, so that bricked voxels (see
+				// BrickedImage) are read brick by brick. This is a tiling of
+				// the one layer only: the sweep still goes layer by layer,
+				// as only two layers are held, and each tile reads a single
+				// z plane of its brick, half of every cache line it touches
+				for (int y0 = 0; y0 < car.h; y0 += TILE) {
+					const int y1 = std::min(y0 + TILE, car.h);
+					for (int x0 = 0; x0 < car.w; x0 += TILE) {
+						const int x1 = std::min(x0 + TILE, car.w);
+						for (int y = y0; y < y1; y++) {
+							for (int x = x0; x < x1; x++)
+								val[index(x, y)] = intensity(x, y, z);
+						}
+					}
+				}
+			}
+			const int n = w * h;
+			for (int i = 0; i < n; i += BLOCK) {
+				for (size_t k = 0; k < isovalues.size(); k++)
+					compare(val + i, isovalues[k].above[layer].data() + i,
+						n - i < BLOCK ? n - i : BLOCK, isovalues[k].t);
+			}
+		}
+
+		/** computes the cases and active cubes of the current layer */
+		void classify() {
+			for (size_t k = 0; k < isovalues.size(); k++)
+				isovalues[k].active.clear();
+			for (int x = -1; x < w - 2; x++) {
+				if (pyramid == nullptr) {
+					classify(x, -1, h - 2);
+					continue;
+				}
+				// runs of active bricks along y
+				const int b = pyramid->brickSize;
+				const int nx = pyramid->levels[0].nx;
+				const int ny = pyramid->levels[0].ny;
+				const unsigned char* column = bricks.data() + (x + 1) / b;
+				for (int by = 0; by < ny; by++) {
+					if (!column[by * nx]) continue;
+					const int y0 = by * b - 1;
+					while (by + 1 < ny && column[(by + 1) * nx]) by++;
+					classify(x, y0, std::min(by * b + b - 1, h - 2));
+				}
+			}
+		}
+
+		/** classifies the cubes (x, y0) to (x, y1 - 1) against all isovalues */
+		void classify(int x, int y0, int y1) {
+			const int j = index(x, y0);
+			for (size_t k = 0; k < isovalues.size(); k++) {
+				Isovalue& iso = isovalues[k];
+				classify(iso.above[0].data() + j, iso.above[1].data() + j, h,
+					iso.cases.data() + j, y1 - y0, j, iso.active);
+			}
+		}
+
+		/** the intensities at the vertexes of the cube with index j */
+		void intensities(int j, V* i) const {
+			const V* s0 = values[0].data();
+			const V* s1 = values[1].data();
+			i[0] = s0[j];
+			i[1] = s0[j + h];
+			i[2] = s0[j + h + 1];
+			i[3] = s0[j + 1];
+			i[4] = s1[j];
+			i[5] = s1[j + h];
+			i[6] = s1[j + h + 1];
+			i[7] = s1[j + 1];
+		}
+
+		/**
+		 * sets above[i] to 1 if values[i] > t, and to 0 otherwise
+		 */
+		static void compare(const int* values, unsigned char* above, int n,
+			int t)
+		{
+			int i = 0;
+#if defined(MC_AVX2)
+			const __m256i vt = _mm256_set1_epi32(t);
+			const __m256i one = _mm256_set1_epi8(1);
+			// packs works per 128 bit lane, this restores the element order
+			const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+			for (; i + 32 <= n; i += 32) {
+				const __m256i* p = (const __m256i*)(values + i);
+				const __m256i a = _mm256_cmpgt_epi32(_mm256_loadu_si256(p + 0), vt);
+				const __m256i b = _mm256_cmpgt_epi32(_mm256_loadu_si256(p + 1), vt);
+				const __m256i c = _mm256_cmpgt_epi32(_mm256_loadu_si256(p + 2), vt);
+				const __m256i d = _mm256_cmpgt_epi32(_mm256_loadu_si256(p + 3), vt);
+				__m256i r = _mm256_packs_epi16(_mm256_packs_epi32(a, b),
+					_mm256_packs_epi32(c, d));
+				r = _mm256_permutevar8x32_epi32(r, order);
+				_mm256_storeu_si256((__m256i*)(above + i), _mm256_and_si256(r, one));
+			}
+#elif defined(MC_SSE2)
+			const __m128i vt = _mm_set1_epi32(t);
+			const __m128i one = _mm_set1_epi8(1);
+			for (; i + 16 <= n; i += 16) {
+				const __m128i* p = (const __m128i*)(values + i);
+				const __m128i a = _mm_cmpgt_epi32(_mm_loadu_si128(p + 0), vt);
+				const __m128i b = _mm_cmpgt_epi32(_mm_loadu_si128(p + 1), vt);
+				const __m128i c = _mm_cmpgt_epi32(_mm_loadu_si128(p + 2), vt);
+				const __m128i d = _mm_cmpgt_epi32(_mm_loadu_si128(p + 3), vt);
+				const __m128i r = _mm_packs_epi16(_mm_packs_epi32(a, b),
+					_mm_packs_epi32(c, d));
+				_mm_storeu_si128((__m128i*)(above + i), _mm_and_si128(r, one));
+			}
+#endif
+			for (; i < n; i++)
+				above[i] = values[i] > t ? 1 : 0;
+		}
+
+		/** compare() for float intensities; NaN is never above */
+		static void compare(const float* values, unsigned char* above, int n,
+			float t)
+		{
+			int i = 0;
+#if defined(MC_AVX2)
+			const __m256 vt = _mm256_set1_ps(t);
+			const __m256i one = _mm256_set1_epi8(1);
+			const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+			for (; i + 32 <= n; i += 32) {
+				const float* p = values + i;
+				const __m256i a = _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(p + 0), vt, _CMP_GT_OQ));
+				const __m256i b = _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(p + 8), vt, _CMP_GT_OQ));
+				const __m256i c = _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(p + 16), vt, _CMP_GT_OQ));
+				const __m256i d = _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(p + 24), vt, _CMP_GT_OQ));
+				__m256i r = _mm256_packs_epi16(_mm256_packs_epi32(a, b),
+					_mm256_packs_epi32(c, d));
+				r = _mm256_permutevar8x32_epi32(r, order);
+				_mm256_storeu_si256((__m256i*)(above + i), _mm256_and_si256(r, one));
+			}
+#elif defined(MC_SSE2)
+			const __m128 vt = _mm_set1_ps(t);
+			const __m128i one = _mm_set1_epi8(1);
+			for (; i + 16 <= n; i += 16) {
+				const float* p = values + i;
+				const __m128i a = _mm_castps_si128(_mm_cmpgt_ps(_mm_loadu_ps(p + 0), vt));
+				const __m128i b = _mm_castps_si128(_mm_cmpgt_ps(_mm_loadu_ps(p + 4), vt));
+				const __m128i c = _mm_castps_si128(_mm_cmpgt_ps(_mm_loadu_ps(p + 8), vt));
+				const __m128i d = _mm_castps_si128(_mm_cmpgt_ps(_mm_loadu_ps(p + 12), vt));
+				const __m128i r = _mm_packs_epi16(_mm_packs_epi32(a, b),
+					_mm_packs_epi32(c, d));
+				_mm_storeu_si128((__m128i*)(above + i), _mm_and_si128(r, one));
 			}
-			offset += 3;
+#endif
+			for (; i < n; i++)
+				above[i] = values[i] > t ? 1 : 0;
+		}
+
+		/**
+		 * computes the case numbers of n cubes along y, given the comparison
+		 * results of their lower and upper layer (stride is the distance
+		 * between two rows), and appends base + i to active for each cube i
+		 * whose case is neither 0 nor 255
+		 */
+		static void classify(const unsigned char* a0, const unsigned char* a1,
+			int stride, unsigned char* cases, int n, int base,
+			std::vector<int>& active)
+		{
+			int i = 0;
+#if defined(MC_AVX2)
+			const __m256i none = _mm256_setzero_si256();
+			const __m256i all = _mm256_set1_epi8((char)0xff);
+			for (; i < n; i += 32) {
+				// the bytes are 0 or 1, so 16 bit shifts do not cross bytes
+				__m256i c = _mm256_loadu_si256((const __m256i*)(a0 + i));
+				c = _mm256_or_si256(c, _mm256_slli_epi16(_mm256_loadu_si256((const __m256i*)(a0 + i + stride)), 1));
+				c = _mm256_or_si256(c, _mm256_slli_epi16(_mm256_loadu_si256((const __m256i*)(a0 + i + stride + 1)), 2));
+				c = _mm256_or_si256(c, _mm256_slli_epi16(_mm256_loadu_si256((const __m256i*)(a0 + i + 1)), 3));
+				c = _mm256_or_si256(c, _mm256_slli_epi16(_mm256_loadu_si256((const __m256i*)(a1 + i)), 4));
+				c = _mm256_or_si256(c, _mm256_slli_epi16(_mm256_loadu_si256((const __m256i*)(a1 + i + stride)), 5));
+				c = _mm256_or_si256(c, _mm256_slli_epi16(_mm256_loadu_si256((const __m256i*)(a1 + i + stride + 1)), 6));
+				c = _mm256_or_si256(c, _mm256_slli_epi16(_mm256_loadu_si256((const __m256i*)(a1 + i + 1)), 7));
+				_mm256_storeu_si256((__m256i*)(cases + i), c);
+				unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(_mm256_or_si256(
+					_mm256_cmpeq_epi8(c, none), _mm256_cmpeq_epi8(c, all)));
+				if (n - i < 32) mask &= (1u << (n - i)) - 1;
+				appendBits(mask, base + i, active);
+			}
+#elif defined(MC_SSE2)
+			const __m128i none = _mm_setzero_si128();
+			const __m128i all = _mm_set1_epi8((char)0xff);
+			for (; i < n; i += 16) {
+				// the bytes are 0 or 1, so 16 bit shifts do not cross bytes
+				__m128i c = _mm_loadu_si128((const __m128i*)(a0 + i));
+				c = _mm_or_si128(c, _mm_slli_epi16(_mm_loadu_si128((const __m128i*)(a0 + i + stride)), 1));
+				c = _mm_or_si128(c, _mm_slli_epi16(_mm_loadu_si128((const __m128i*)(a0 + i + stride + 1)), 2));
+				c = _mm_or_si128(c, _mm_slli_epi16(_mm_loadu_si128((const __m128i*)(a0 + i + 1)), 3));
+				c = _mm_or_si128(c, _mm_slli_epi16(_mm_loadu_si128((const __m128i*)(a1 + i)), 4));
+				c = _mm_or_si128(c, _mm_slli_epi16(_mm_loadu_si128((const __m128i*)(a1 + i + stride)), 5));
+				c = _mm_or_si128(c, _mm_slli_epi16(_mm_loadu_si128((const __m128i*)(a1 + i + stride + 1)), 6));
+				c = _mm_or_si128(c, _mm_slli_epi16(_mm_loadu_si128((const __m128i*)(a1 + i + 1)), 7));
+				_mm_storeu_si128((__m128i*)(cases + i), c);
+				unsigned int mask = 0xffff & ~(unsigned int)_mm_movemask_epi8(_mm_or_si128(
+					_mm_cmpeq_epi8(c, none), _mm_cmpeq_epi8(c, all)));
+				if (n - i < 16) mask &= (1u << (n - i)) - 1;
+				appendBits(mask, base + i, active);
+			}
+#else
+			for (; i < n; i++) {
+				const int c = a0[i] | a0[i + stride] << 1 | a0[i + stride + 1] << 2 |
+					a0[i + 1] << 3 | a1[i] << 4 | a1[i + stride] << 5 |
+					a1[i + stride + 1] << 6 | a1[i + 1] << 7;
+				cases[i] = (unsigned char)c;
+				if (c != 0 && c != 255) active.push_back(base + i);
+			}
+#endif
+		}
+
+		/** appends base + b to list for each bit b set in mask */
+		static void appendBits(unsigned int mask, int base, std::vector<int>& list) {
+			while (mask != 0) {
+#if defined(_MSC_VER)
+				unsigned long b;
+				_BitScanForward(&b, mask);
+#else
+				const int b = __builtin_ctz(mask);
+#endif
+				list.push_back(base + (int)b);
+				mask &= mask - 1;
+			}
+		}
+	};
+
+	typedef BasicSliceCache<int> SliceCache;
+
+	/**
+	 * Maps the edges of the two vertex layers touched by one layer of cubes to
+	 * their index in the vertex list. Each vertex layer has its own map, which
+	 * is cleared once no cube can reference it any more.
+	 */
+	struct EdgeIndex {
+		// dimensions of a padded vertex layer
+		long long w, h;
+		std::unordered_map<long long, uint32_t> layers[2];
+
+		EdgeIndex(int w, int h) : w(w + 3), h(h + 3) {}
+
+		/** Called before the cubes of layer z are processed. */
+		void startLayer(int z) {
+			// the layer z - 1 shares its slot with the layer z + 1
+			layers[(z + 2) & 1].clear();
+		}
+	};
+
+	/**
+	 * returns the index of the interpolated point on the given edge of the
+	 * cube, adding the point to the vertex list if it is not there yet
+	 */
+private:
+	uint32_t edgeVertex(int edge, EdgeIndex& edges,
+		std::vector<vec3>& vertices)
+	{
+		// origin (relative to v0) and axis of each edge
+		static const int edgeOrigins[12][4] = {
+			{ 0, 0, 0, 0 }, { 1, 0, 0, 1 }, { 0, 1, 0, 0 }, { 0, 0, 0, 1 },
+			{ 0, 0, 1, 0 }, { 1, 0, 1, 1 }, { 0, 1, 1, 0 }, { 0, 0, 1, 1 },
+			{ 0, 0, 0, 2 }, { 1, 0, 0, 2 }, { 0, 1, 0, 2 }, { 1, 1, 0, 2 } };
+		const int* o = edgeOrigins[edge];
+		const long long x = (long long)v[0].x + o[0] + 1;
+		const long long y = (long long)v[0].y + o[1] + 1;
+		const int z = (int)v[0].z + o[2];
+		const long long key = (y * edges.w + x) * 3 + o[3];
+
+		std::unordered_map<long long, uint32_t>& layer = edges.layers[(z + 1) & 1];
+		std::unordered_map<long long, uint32_t>::iterator it = layer.find(key);
+		if (it != layer.end())
+			return it->second;
+		const uint32_t index = (uint32_t)vertices.size();
+		vertices.push_back(e[edge]);
+		layer[key] = index;
+		return index;
+	}
+
+private:
+	void getTriangles(std::vector<vec3>& vertices,
+		std::vector<uint32_t>& indices, EdgeIndex& edges, int cn)
+	{
+		const MCTables::Case& c = MCTables::caseTable[cn];
+		for (int index = 0; index < 3 * c.count; index += 3) {
+			indices.push_back(edgeVertex(c.edges[index + 0], edges, vertices));
+			indices.push_back(edgeVertex(c.edges[index + 1], edges, vertices));
+			indices.push_back(edgeVertex(c.edges[index + 2], edges, vertices));
 		}
 	}
 
@@ -168,7 +657,7 @@ private:
 	 * @return the number of the case corresponding to the cube
 	 */
 private:
-	int caseNumber(Carrier car) {
+	int caseNumber(Carrier& car) {
 		int caseNumber = 0;
 		for (int index = -1; ++index < v.size(); 
 			caseNumber += (car.intensity(v[index]) - car.threshold > 0) ? 1 << index : 0);
@@ -184,12 +673,675 @@ private:
 	 * @return
 	 */
 public: 
-	std::vector<vec3> getTriangles(
+	static std::vector<vec3> getTriangles(
 		//Volume volume,
 		int volume,
 		int thresh)
 	{
+		/*
+		if (volume instanceof AreaListVolume) {
+			return getTriangles(MCCube(), (AreaListVolume)volume, car, tri);
+		}
+		*/
+		return getTriangles(volume, thresh, 1);
+	}
+
+	/**
+	 * Create a list of triangles from the specified image data and the given
+	 * isovalue, using several threads. The volume is split into z-slabs, each
+	 * of which is triangulated by its own worker with its own MCCube and
+	 * Carrier.
+	 *
+	 * The output is allocated exactly once: a first pass counts the
+	 * triangles of every layer of cubes from the case numbers alone, and the
+	 * prefix sum of these counts gives the offset of each layer in the
+	 * output. The second pass then writes the triangles of each slab at its
+	 * offset, without any synchronization. The result is identical to the
+	 * one of getTriangles(volume, thresh).
+	 *
+	 * @param volume
+	 * @param thresh
+	 * @param nThreads number of worker threads; if <= 0, one per hardware
+	 *          thread is used
+	 * @return
+	 */
+public:
+	static std::vector<vec3> getTriangles(
+		//Volume volume,
+		int volume,
+		int thresh,
+		int nThreads)
+	{
+		const Carrier car = createCarrier(volume, thresh);
 		std::vector<vec3> tri;
+		// the loader is resolved once, here, rather than for every voxel
+		volume.withLoader([&](const auto& loader) {
+			tri = getTriangles(car, nThreads, [&loader](int x, int y, int z) {
+				return loader.load(x, y, z);
+			});
+		});
+
+		convertCoordinates(tri, volume);
+		return tri;
+	}
+
+	/**
+	 * Like getTriangles(volume, thresh, nThreads), but on the intensities in
+	 * the native type of the image (see Volume.withNativeLoader()): 16 bit
+	 * data is compared as it is, without being reduced to 8 bit, and 32 bit
+	 * data as float, without being truncated. A vertex is inside if its
+	 * intensity is above threshold; for integer data, threshold t + 0.5 gives
+	 * the triangles of getTriangles(volume, t, nThreads).
+	 *
+	 * @param volume
+	 * @param threshold the isovalue
+	 * @param nThreads number of worker threads; if <= 0, one per hardware
+	 *          thread is used
+	 * @return
+	 */
+public:
+	static std::vector<vec3> getNativeTriangles(
+		//Volume volume,
+		int volume,
+		float threshold,
+		int nThreads)
+	{
+		Carrier car = createCarrier(volume, 0);
+		car.threshold = threshold;
+		std::vector<vec3> tri;
+		volume.withNativeLoader([&](const auto& loader) {
+			tri = getTriangles(car, nThreads, [&loader](int x, int y, int z) {
+				return loader.load(x, y, z);
+			});
+		});
+
+		convertCoordinates(tri, volume);
+		return tri;
+	}
+
+	/**
+	 * The body of getTriangles(volume, thresh, nThreads), reading the
+	 * intensities of the in-bounds voxels with intensity(x, y, z), which is
+	 * called concurrently. The cubes are classified and interpolated in the
+	 * type intensity() returns, int or float. Returns pixel coordinates.
+	 */
+private:
+	template <typename Intensity>
+	static std::vector<vec3> getTriangles(const Carrier& carrier, int nThreads,
+		Intensity intensity)
+	{
+		typedef typename std::decay<decltype(intensity(0, 0, 0))>::type V;
+		Carrier car = carrier;
+		// the pyramid holds the int intensities, which truncate float ones
+		if (std::is_floating_point<V>::value) car.pyramid = nullptr;
+
+		// z runs from -1 to d inclusive
+		const int nSlices = car.d + 2;
+		if (nThreads <= 0)
+			nThreads = (int)std::thread::hardware_concurrency();
+		nThreads = std::max(1, std::min(nThreads, nSlices));
+
+		// the triangles of layer z, turned into the offset of layer z
+		std::vector<size_t> offsets(nSlices + 1, 0);
+		forEachSlab(car, nThreads, [&offsets, &intensity](Carrier& car, int z0, int z1) {
+			countTriangles(car, z0, z1, intensity, &offsets[z0 + 1]);
+		});
+		size_t total = 0;
+		for (int i = 0; i < nSlices; i++) {
+			const size_t n = offsets[i];
+			offsets[i] = total;
+			total += n;
+		}
+		offsets[nSlices] = total;
+
+		std::vector<vec3> tri(3 * total);
+		vec3* out = tri.data();
+		forEachSlab(car, nThreads, [&offsets, &intensity, out](Carrier& car, int z0, int z1) {
+			getTriangles(car, z0, z1, intensity, out + 3 * offsets[z0 + 1]);
+		});
+		return tri;
+	}
+
+	/**
+	 * Runs f(car, z0, z1) for nThreads consecutive z-slabs of the layers of
+	 * cubes -1 to d, each on its own thread with its own copy of the Carrier.
+	 */
+private:
+	template <typename F>
+	static void forEachSlab(const Carrier& car, int nThreads, F f) {
+		const int nSlices = car.d + 2;
+		std::vector<std::thread> workers;
+		for (int i = 0; i < nThreads; i++) {
+			const int z0 = -1 + (int)((long long)nSlices * i / nThreads);
+			const int z1 = -1 + (int)((long long)nSlices * (i + 1) / nThreads);
+			workers.push_back(std::thread([&car, &f, z0, z1]() {
+				Carrier own = car;
+				f(own, z0, z1);
+			}));
+		}
+		for (int i = 0; i < nThreads; i++)
+			workers[i].join();
+	}
+
+	/**
+	 * Create an indexed triangle mesh from the specified image data and the
+	 * given isovalue. Points on edges shared by neighbouring cubes are stored
+	 * only once in vertices; each triangle is given by three consecutive
+	 * entries of indices. The triangles are the same as the ones returned by
+	 * getTriangles(volume, thresh), in the same order.
+	 *
+	 * @param volume
+	 * @param thresh
+	 * @param vertices receives the vertices of the mesh
+	 * @param indices receives three vertex indices per triangle
+	 */
+public:
+	static void getIndexedTriangles(
+		//Volume volume,
+		int volume,
+		int thresh,
+		std::vector<vec3>& vertices,
+		std::vector<uint32_t>& indices)
+	{
+		Carrier car = createCarrier(volume, thresh);
+		EdgeIndex edges(car.w, car.h);
+		SliceCache slices(car);
+		const SliceCache::Isovalue& iso = slices.isovalues[0];
+		int i[8];
+
+		MCCube cube = MCCube();
+		for (int z = -1; z < car.d + 1; z += 1) {
+			edges.startLayer(z);
+			if (!slices.startLayer(car, z)) continue;
+			for (size_t k = 0; k < iso.active.size(); k++) {
+				const int j = iso.active[k];
+				cube.init(j / slices.h - 1, j % slices.h - 1, z);
+				slices.intensities(j, i);
+				cube.computeEdges(i, car);
+				cube.getTriangles(vertices, indices, edges, iso.cases[j]);
+			}
+			//IJ.showProgress(z, car.d - 2);
+		}
+
+		convertCoordinates(vertices, volume);
+	}
+
+	/**
+	 * Create the triangles for the given isovalue and pass them to sink as
+	 * they are produced, so that the whole mesh is never held in memory.
+	 * sink(const vec3* points, size_t n) is called with batches of n points
+	 * in calibrated coordinates, three per triangle; all batches hold
+	 * exactly batchSize triangles, except for the last one, which may hold
+	 * fewer. The triangles are the ones of getTriangles(volume, thresh), in
+	 * the same order; the points are only valid during the call.
+	 *
+	 * @param volume
+	 * @param thresh
+	 * @param sink
+	 * @param batchSize number of triangles per batch
+	 */
+public:
+	template <typename Sink>
+	static void streamTriangles(
+		//Volume volume,
+		int volume,
+		int thresh,
+		Sink&& sink,
+		size_t batchSize = 4096)
+	{
+		Carrier car = createCarrier(volume, thresh);
+		SliceCache slices(car);
+		Batches<Sink> out(sink, volume, batchSize);
+		streamTriangles(car, slices, -1, car.d + 1, [&car](int x, int y, int z) {
+			return car.intensity(vec3(x, y, z));
+		}, out);
+		out.flush(true);
+	}
+
+	/**
+	 * Out-of-core variant of streamTriangles(), for volumes which do not fit
+	 * into memory. The volume is read in z-slabs of chunkDepth slices plus a
+	 * one slice halo, which is the first slice of the next slab, with
+	 * readSlice(int z, int* values); it fills values with the intensities of
+	 * slice z, at y * w + x. Only one slab is held in memory at a time, and
+	 * the halo is kept for the next slab rather than read again.
+	 *
+	 * The cubes on either side of a seam are computed from the same
+	 * intensities, so the points on the seams are identical and the mesh is
+	 * the one of getTriangles(volume, thresh), in the same order.
+	 *
+	 * @param volume
+	 * @param thresh
+	 * @param chunkDepth number of slices per slab
+	 * @param readSlice
+	 * @param sink see streamTriangles()
+	 * @param batchSize number of triangles per batch
+	 */
+public:
+	template <typename ReadSlice, typename Sink>
+	static void streamChunkedTriangles(
+		//Volume volume,
+		int volume,
+		int thresh,
+		int chunkDepth,
+		ReadSlice&& readSlice,
+		Sink&& sink,
+		size_t batchSize = 4096)
+	{
+		Carrier car = createCarrier(volume, thresh);
+		// the pyramid would need the whole volume
+		car.pyramid = nullptr;
+		SliceCache slices(car);
+		Batches<Sink> out(sink, volume, batchSize);
+
+		chunkDepth = std::max(1, chunkDepth);
+		const size_t size = (size_t)car.w * car.h;
+		std::vector<int> chunk((chunkDepth + 1) * size);
+		// the slab holds the slices first to last
+		int first = 0, last = -1;
+		for (int z0 = -1; z0 < car.d + 1; z0 += chunkDepth) {
+			// the cubes of layer z touch the slices z and z + 1
+			const int z1 = std::min(z0 + chunkDepth, car.d + 1);
+			const int s0 = std::max(z0, 0), s1 = std::min(z1, car.d - 1);
+			int next = s0;
+			if (s0 == last) {
+				// the halo of the previous slab, which is in place already if
+				// the slab was a single slice
+				if (last != first)
+					std::copy(chunk.begin() + (last - first) * size,
+						chunk.begin() + (last - first + 1) * size, chunk.begin());
+				next++;
+			}
+			first = s0;
+			for (int s = next; s <= s1; s++)
+				readSlice(s, chunk.data() + (s - first) * size);
+			last = std::max(s1, last);
+
+			const int* data = chunk.data();
+			const int w = car.w, h = car.h;
+			streamTriangles(car, slices, z0, z1, [data, first, w, h](int x, int y, int z) {
+				return data[((size_t)(z - first) * h + y) * w + x];
+			}, out);
+		}
+		out.flush(true);
+	}
+
+	/**
+	 * Create the meshes of a level of detail pyramid for the given isovalue,
+	 * in a single pass over the volume. Mesh k is triangulated from the
+	 * volume downsampled by 2^k, where each voxel is the mean of the 2^k
+	 * cubed voxels it covers (see DownsamplingCascade). Mesh 0 is the one of
+	 * getTriangles(volume, thresh); it is triangulated while its slices are
+	 * read and fed into the cascade, which then holds all coarser levels:
+	 * at most a seventh as many voxels as the volume, stored as int, i.e. up
+	 * to 4/7 of the size of an 8 bit volume.
+	 *
+	 * The coordinates of the coarser meshes are scaled like the ones of a
+	 * volume resampled by MCTriangulator, so all meshes overlap.
+	 *
+	 * @param volume
+	 * @param thresh
+	 * @param nLevels number of meshes, for the factors 1, 2, 4, ...
+	 * @return the mesh for the factor 2^k at index k
+	 */
+public:
+	static std::vector<std::vector<vec3>> getLODTriangles(
+		//Volume volume,
+		int volume,
+		int thresh,
+		int nLevels = 4)
+	{
+		nLevels = std::max(1, nLevels);
+		std::vector<std::vector<vec3>> tri(nLevels);
+		Carrier source = createCarrier(volume, thresh);
+		DownsamplingCascade cascade(source.w, source.h, source.d, nLevels - 1);
+
+		std::vector<vec3>& level0 = tri[0];
+		streamChunkedTriangles(volume, thresh, 1,
+			[&source, &cascade](int z, int* values) {
+				for (int y = 0; y < source.h; y++)
+					for (int x = 0; x < source.w; x++)
+						values[y * source.w + x] = source.intensity(vec3(x, y, z));
+				cascade.addSlice(z, values);
+			},
+			[&level0](const vec3* points, size_t n) {
+				level0.insert(level0.end(), points, points + n);
+			});
+
+		for (int k = 1; k < nLevels; k++) {
+			const DownsamplingCascade::Level& l = cascade.levels[k - 1];
+			Carrier car = source;
+			car.w = l.w;
+			car.h = l.h;
+			car.d = l.d;
+			car.pyramid = nullptr;
+			getTriangles(car, -1, car.d + 1, [&l](int x, int y, int z) {
+				return l.intensity(x, y, z);
+			}, tri[k]);
+			// to the pixel coordinates of the source
+			const float f = (float)(1 << k);
+			for (size_t i = 0; i < tri[k].size(); i++)
+				tri[k][i] *= f;
+			convertCoordinates(tri[k], volume);
+		}
+		return tri;
+	}
+
+	/**
+	 * Buffers triangles and passes them to a sink in batches of exactly n
+	 * points, in calibrated coordinates.
+	 */
+	template <typename Sink>
+	struct Batches {
+		Sink& sink;
+		int volume;
+		size_t n;
+		std::vector<vec3> points;
+
+		Batches(Sink& sink, int volume, size_t batchSize) : sink(sink),
+			volume(volume), n(3 * std::max<size_t>(batchSize, 1))
+		{
+			// room for the triangles of one more cube
+			points.reserve(n + 15);
+		}
+
+		/** passes the full batches to the sink, and the rest if last */
+		void flush(bool last) {
+			size_t done = 0;
+			for (; points.size() - done >= n; done += n) {
+				convertCoordinates(points.data() + done, n, volume);
+				sink((const vec3*)points.data() + done, n);
+			}
+			if (last && done < points.size()) {
+				convertCoordinates(points.data() + done, points.size() - done, volume);
+				sink((const vec3*)points.data() + done, points.size() - done);
+				done = points.size();
+			}
+			points.erase(points.begin(), points.begin() + done);
+		}
+	};
+
+	/**
+	 * Triangulates all cubes with z0 <= z < z1 into out, reading the
+	 * intensities with intensity(x, y, z).
+	 */
+private:
+	template <typename Intensity, typename Sink>
+	static void streamTriangles(Carrier& car, SliceCache& slices, int z0,
+		int z1, Intensity intensity, Batches<Sink>& out)
+	{
+		const SliceCache::Isovalue& iso = slices.isovalues[0];
+		int i[8];
+
+		MCCube cube = MCCube();
+		for (int z = z0; z < z1; z += 1) {
+			if (!slices.startLayer(car, z, intensity)) continue;
+			for (size_t k = 0; k < iso.active.size(); k++) {
+				const int j = iso.active[k];
+				cube.init(j / slices.h - 1, j % slices.h - 1, z);
+				slices.intensities(j, i);
+				cube.computeEdges(i, car);
+				cube.getTriangles(out.points, iso.cases[j]);
+				if (out.points.size() >= out.n) out.flush(false);
+			}
+			//IJ.showProgress(z, car.d - 2);
+		}
+	}
+
+	/**
+	 * Create one list of triangles per isovalue from the specified image
+	 * data, in a single pass over the volume: each block of intensities is
+	 * loaded once and classified against all isovalues. The list of each
+	 * isovalue is identical to the one of getTriangles(volume, thresh).
+	 *
+	 * As in getTriangles(volume, thresh, nThreads), the lists are allocated
+	 * exactly once: a counting pass gives the offset of every layer of cubes
+	 * in the list of every isovalue, and the slabs then write their
+	 * triangles there.
+	 *
+	 * @param volume
+	 * @param thresholds
+	 * @param nThreads number of worker threads; if <= 0, one per hardware
+	 *          thread is used
+	 * @return the triangles of thresholds[i] at index i
+	 */
+public:
+	static std::vector<std::vector<vec3>> getTriangles(
+		//Volume volume,
+		int volume,
+		const std::vector<int>& thresholds,
+		int nThreads = 1)
+	{
+		const Carrier car = createCarrier(volume, 0);
+		std::vector<float> t(thresholds.size());
+		for (size_t k = 0; k < thresholds.size(); k++)
+			t[k] = thresholds[k] + 0.5f;
+
+		// z runs from -1 to d inclusive, see getTriangles(volume, thresh)
+		const int nSlices = car.d + 2;
+		if (nThreads <= 0)
+			nThreads = (int)std::thread::hardware_concurrency();
+		nThreads = std::max(1, std::min(nThreads, nSlices));
+
+		// per isovalue, the triangles of layer z, turned into the offset of
+		// layer z
+		const size_t nIso = t.size();
+		std::vector<std::vector<size_t>> offsets(nIso,
+			std::vector<size_t>(nSlices + 1, 0));
+		forEachSlab(car, nThreads, [&t, &offsets](Carrier& car, int z0, int z1) {
+			countTriangles(car, t, z0, z1, offsets);
+		});
+
+		std::vector<std::vector<vec3>> tri(nIso);
+		std::vector<vec3*> out(nIso);
+		for (size_t k = 0; k < nIso; k++) {
+			size_t total = 0;
+			for (int i = 0; i < nSlices; i++) {
+				const size_t n = offsets[k][i];
+				offsets[k][i] = total;
+				total += n;
+			}
+			offsets[k][nSlices] = total;
+			tri[k].resize(3 * total);
+			out[k] = tri[k].data();
+		}
+		forEachSlab(car, nThreads, [&t, &offsets, &out](Carrier& car, int z0, int z1) {
+			getTriangles(car, t, z0, z1, offsets, out);
+		});
+
+		for (size_t k = 0; k < nIso; k++)
+			convertCoordinates(tri[k], volume);
+		return tri;
+	}
+
+	/**
+	 * Counts the triangles of each layer of cubes z0 <= z < z1 into
+	 * counts[z - z0], without computing any of them.
+	 */
+private:
+	template <typename Intensity>
+	static void countTriangles(Carrier& car, int z0, int z1,
+		Intensity& intensity, size_t* counts)
+	{
+		typedef typename std::decay<decltype(intensity(0, 0, 0))>::type V;
+		BasicSliceCache<V> slices(car);
+		const typename BasicSliceCache<V>::Isovalue& iso = slices.isovalues[0];
+		for (int z = z0; z < z1; z += 1) {
+			counts[z - z0] = 0;
+			if (!slices.startLayer(car, z, intensity)) continue;
+			size_t n = 0;
+			for (size_t k = 0; k < iso.active.size(); k++)
+				n += MCTables::caseTable[iso.cases[iso.active[k]]].count;
+			counts[z - z0] = n;
+		}
+	}
+
+	/**
+	 * Triangulates all cubes with z0 <= z < z1 into out, which must have
+	 * room for all of their triangles (see countTriangles()).
+	 */
+private:
+	template <typename Intensity>
+	static void getTriangles(Carrier& car, int z0, int z1,
+		Intensity& intensity, vec3* out)
+	{
+		typedef typename std::decay<decltype(intensity(0, 0, 0))>::type V;
+		BasicSliceCache<V> slices(car);
+		const typename BasicSliceCache<V>::Isovalue& iso = slices.isovalues[0];
+		V i[8];
+
+		MCCube cube = MCCube();
+		for (int z = z0; z < z1; z += 1) {
+			if (!slices.startLayer(car, z, intensity)) continue;
+			for (size_t k = 0; k < iso.active.size(); k++) {
+				const int j = iso.active[k];
+				cube.init(j / slices.h - 1, j % slices.h - 1, z);
+				slices.intensities(j, i);
+				cube.computeEdges(i, car);
+				out = cube.getTriangles(out, iso.cases[j]);
+			}
+			//IJ.showProgress(z, car.d - 2);
+		}
+	}
+
+	/**
+	 * Triangulates all cubes with z0 <= z < z1 and appends the triangles to
+	 * the given list, in the same z/x/y order as getTriangles(volume, thresh).
+	 * The intensities of the in-bounds voxels are read with
+	 * intensity(x, y, z).
+	 */
+private:
+	template <typename Intensity>
+	static void getTriangles(Carrier& car, int z0, int z1,
+		Intensity intensity, std::vector<vec3>& tri)
+	{
+		SliceCache slices(car);
+		const SliceCache::Isovalue& iso = slices.isovalues[0];
+		int i[8];
+
+		MCCube cube = MCCube();
+		for (int z = z0; z < z1; z += 1) {
+			if (!slices.startLayer(car, z, intensity)) continue;
+			// only cubes with a case other than 0 and 255 have triangles
+			for (size_t k = 0; k < iso.active.size(); k++) {
+				const int j = iso.active[k];
+				cube.init(j / slices.h - 1, j % slices.h - 1, z);
+				slices.intensities(j, i);
+				cube.computeEdges(i, car);
+				cube.getTriangles(tri, iso.cases[j]);
+			}
+			//IJ.showProgress(z, car.d - 2);
+		}
+	}
+
+	/**
+	 * Counts the triangles of each layer of cubes z0 <= z < z1 against each
+	 * of the given thresholds into counts[k][z + 1] for thresholds[k],
+	 * without computing any of them.
+	 */
+private:
+	static void countTriangles(Carrier& car, const std::vector<float>& thresholds,
+		int z0, int z1, std::vector<std::vector<size_t>>& counts)
+	{
+		SliceCache slices(car, thresholds);
+		for (int z = z0; z < z1; z += 1) {
+			for (size_t k = 0; k < thresholds.size(); k++)
+				counts[k][z + 1] = 0;
+			if (!slices.startLayer(car, z)) continue;
+			for (size_t k = 0; k < slices.isovalues.size(); k++) {
+				const SliceCache::Isovalue& iso = slices.isovalues[k];
+				size_t n = 0;
+				for (size_t a = 0; a < iso.active.size(); a++)
+					n += MCTables::caseTable[iso.cases[iso.active[a]]].count;
+				counts[k][z + 1] = n;
+			}
+		}
+	}
+
+	/**
+	 * Triangulates all cubes with z0 <= z < z1 against each of the given
+	 * thresholds, into out[k] for thresholds[k], starting at the offset of
+	 * layer z0 (offsets[k][z0 + 1], see countTriangles()), each in the same
+	 * z/x/y order as getTriangles(volume, thresh).
+	 */
+private:
+	static void getTriangles(Carrier& car, const std::vector<float>& thresholds,
+		int z0, int z1, const std::vector<std::vector<size_t>>& offsets,
+		const std::vector<vec3*>& out)
+	{
+		SliceCache slices(car, thresholds);
+		std::vector<vec3*> next(thresholds.size());
+		for (size_t k = 0; k < thresholds.size(); k++)
+			next[k] = out[k] + 3 * offsets[k][z0 + 1];
+		int i[8];
+
+		MCCube cube = MCCube();
+		for (int z = z0; z < z1; z += 1) {
+			if (!slices.startLayer(car, z)) continue;
+			for (size_t n = 0; n < slices.isovalues.size(); n++) {
+				const SliceCache::Isovalue& iso = slices.isovalues[n];
+				car.threshold = iso.threshold;
+				for (size_t k = 0; k < iso.active.size(); k++) {
+					const int j = iso.active[k];
+					cube.init(j / slices.h - 1, j % slices.h - 1, z);
+					slices.intensities(j, i);
+					cube.computeEdges(i, car);
+					next[n] = cube.getTriangles(next[n], iso.cases[j]);
+				}
+			}
+			//IJ.showProgress(z, car.d - 2);
+		}
+	}
+
+	/**
+	 * Triangulates the cubes (x, y, z) with x0 <= x < x1, y0 <= y < y1 and
+	 * z0 <= z < z1 and appends the triangles to the given list, in z/x/y
+	 * order. The vertexes of the box are loaded once, up front.
+	 */
+private:
+	static void getTriangles(Carrier& car, int x0, int y0, int z0,
+		int x1, int y1, int z1, std::vector<vec3>& tri)
+	{
+		const int nx = x1 - x0 + 1, ny = y1 - y0 + 1, nz = z1 - z0 + 1;
+		if (nx < 2 || ny < 2 || nz < 2) return;
+		std::vector<int> values((size_t)nx * ny * nz);
+		for (int z = 0; z < nz; z++)
+			for (int y = 0; y < ny; y++)
+				for (int x = 0; x < nx; x++)
+					values[((size_t)z * ny + y) * nx + x] =
+						car.intensity(vec3(x0 + x, y0 + y, z0 + z));
+
+		// offsets of the vertexes of a cube, in the order of init()
+		const size_t sy = nx, sz = (size_t)nx * ny;
+		const size_t offsets[8] = { 0, 1, 1 + sy, sy,
+			sz, 1 + sz, 1 + sy + sz, sy + sz };
+		int i[8];
+
+		MCCube cube = MCCube();
+		for (int z = z0; z < z1; z += 1) {
+			for (int x = x0; x < x1; x += 1) {
+				for (int y = y0; y < y1; y += 1) {
+					const int* v0 = &values[((size_t)(z - z0) * ny + (y - y0)) * nx + (x - x0)];
+					int cn = 0;
+					for (int k = 0; k < 8; k++) {
+						i[k] = v0[offsets[k]];
+						cn |= (i[k] - car.threshold > 0) ? 1 << k : 0;
+					}
+					if (cn == 0 || cn == 255) continue;
+					cube.init(x, y, z);
+					cube.computeEdges(i, car);
+					cube.getTriangles(tri, cn);
+				}
+			}
+		}
+	}
+
+private:
+	static Carrier createCarrier(
+		//Volume volume,
+		int volume,
+		int thresh)
+	{
 		Carrier car = Carrier();
 		//car.w = volume.xDim;
 		//car.h = volume.yDim;
@@ -199,27 +1351,28 @@ public:
 		car.d = volume;
 		car.threshold = thresh + 0.5f;
 		car.volume = volume;
+		car.pyramid = volume.getMinMaxPyramid().get();
+		return car;
+	}
 
-		MCCube cube = MCCube();
-		/*
-		if (volume instanceof AreaListVolume) {
-			return getTriangles(cube, (AreaListVolume)volume, car, tri);
-		}
-		*/
-		for (int z = -1; z < car.d + 1; z += 1) {
-			for (int x = -1; x < car.w + 1; x += 1) {
-				for (int y = -1; y < car.h + 1; y += 1) {
-					cube.init(x, y, z);
-					cube.computeEdges(car);
-					cube.getTriangles(tri, car);
-				}
-			}
-			//IJ.showProgress(z, car.d - 2);
-		}
+	/**
+	 * Converts pixel coordinates into calibrated coordinates, in place.
+	 */
+private:
+	static void convertCoordinates(std::vector<vec3>& tri,
+		//Volume volume
+		int volume)
+	{
+		convertCoordinates(tri.data(), tri.size(), volume);
+	}
 
-		// convert pixel coordinates
-		for (int i = 0; i < tri.size(); i++) {
-			vec3 p = tri.at(i);
+private:
+	static void convertCoordinates(vec3* tri, size_t n,
+		//Volume volume
+		int volume)
+	{
+		for (size_t i = 0; i < n; i++) {
+			vec3& p = tri[i];
 			//p.x = (float)(p.x * volume.pw + volume.minCoord.x);
 			//p.y = (float)(p.y * volume.ph + volume.minCoord.y);
 			//p.z = (float)(p.z * volume.pd + volume.minCoord.z);
@@ -227,11 +1380,17 @@ public:
 			p.y = (float)(p.y * volume + volume);
 			p.z = (float)(p.z * volume + volume);
 		}
-		return tri;
 	}
 
+	// the number of cubes of a tile of the AreaListVolume helper below
+	static const int TILE_CUBES = 1 << 14;
+
 	/**
-	 * An efficient helper for {@link AreaListVolume}s.
+	 * An efficient helper for {@link AreaListVolume}s. The cubes are scanned
+	 * in tiles of about TILE_CUBES cubes, in parallel; the triangles are in
+	 * the same order as with a single thread. Within a rectangle, the cubes
+	 * are scanned row by row (y outer, x inner), not column by column as
+	 * before, so the same triangles come in a different order.
 	 *
 	 * @param volume the volume
 	 * @param tri the {@link List} to which to add the triangles
@@ -246,40 +1405,36 @@ private:
 		std::vector<vec3> tri)
 	{
 		std::vector<std::vector<Area>> list = volume.getAreas();
-		final Area[] sectionAreas = new Area[list.size()];
+		final int n = list.size();
+		final Area[] sectionAreas = new Area[n];
 		// Create one Area for each section, composed of the addition of all Shape
-		// instances
-		int next = -1;
-		for (final List<Area> shapeList : list) {
-			next++;
-			if (shapeList.isEmpty()) continue;
-			final Area a = shapeList.get(0);
-			for (int i = 1; i < shapeList.size(); i++) {
-				a.add(new Area(shapeList.get(i)));
-			}
-			sectionAreas[next] = a;
-		}
-		// Fuse Area instances for previous and next sections
-		final Area[] scanAreas = new Area[sectionAreas.length];
-		for (int i = 0; i < sectionAreas.length; i++) {
-			if (null == sectionAreas[i]) continue;
+		// instances; sections are independent, so they are built in parallel
+		IntStream.range(0, n).parallel().forEach(i -> {
+			final List<Area> shapeList = list.get(i);
+			if (shapeList.isEmpty()) return;
+			// a copy, not to change the Areas of the volume
+			final Area a = new Area(shapeList.get(0));
+			for (int k = 1; k < shapeList.size(); k++) {
+				a.add(new Area(shapeList.get(k)));
+			}
+			sectionAreas[i] = a;
+		});
+		// Fuse Area instances for previous and next sections, and collect the
+		// cubes touching each subarea as disjoint rectangles, so that no cube
+		// is visited, and triangulated, twice
+		final List<Rectangle>[] sectionBounds = new List[n];
+		IntStream.range(0, n).parallel().forEach(i -> {
+			if (null == sectionAreas[i]) return;
 			final Area a = new Area(sectionAreas[i]);
-			if (i - 1 < 0 || null == sectionAreas[i - 1]) {}
-			else a.add(sectionAreas[i - 1]);
-			if (i + 1 > sectionAreas.length - 1 || null == sectionAreas[i + 1]) {}
-			else a.add(sectionAreas[i + 1]);
-			scanAreas[i] = a;
-		}
-		// Collect the bounds of all subareas in each scanArea:
-		final Map<Integer, ArrayList<Rectangle>> sectionBounds =
-			new HashMap<Integer, ArrayList<Rectangle>>();
-		for (int i = 0; i < scanAreas.length; i++) {
-			if (null == scanAreas[i]) continue;
-			final ArrayList<Rectangle> bs = new ArrayList<Rectangle>();
+			if (i - 1 >= 0 && null != sectionAreas[i - 1])
+				a.add(sectionAreas[i - 1]);
+			if (i + 1 < n && null != sectionAreas[i + 1])
+				a.add(sectionAreas[i + 1]);
+			final ArrayList<Rectangle> cubes = new ArrayList<Rectangle>();
 			Polygon pol = new Polygon();
 			final float[] coords = new float[6];
-			for (final PathIterator pit = scanAreas[i].getPathIterator(null); !pit
-				.isDone(); pit.next())
+			for (final PathIterator pit = a.getPathIterator(null); !pit.isDone(); pit
+				.next())
 			{
 				switch (pit.currentSegment(coords)) {
 				case PathIterator.SEG_MOVETO:
@@ -287,7 +1442,9 @@ private:
 					pol.addPoint((int)coords[0], (int)coords[1]);
 					break;
 				case PathIterator.SEG_CLOSE:
-					bs.add(pol.getBounds());
+					final Rectangle bounds = pol.getBounds();
+					cubes.add(new Rectangle(bounds.x - 1, bounds.y - 1,
+						bounds.width + 3, bounds.height + 3));
 					pol = new Polygon();
 					break;
 				default:
@@ -295,29 +1452,83 @@ private:
 					break;
 				}
 			}
-			sectionBounds.put(i, bs);
-		}
+			sectionBounds[i] = disjoint(cubes);
+		});
 
-		// Add Z paddings on top and bottom
-		sectionBounds.put(-1, sectionBounds.get(0));
-		sectionBounds.put(car.d, sectionBounds.get(car.d - 1));
-
-		// Scan only relevant areas:
-		for (int z = -1; z < car.d + 1; z += 1) {
-			final ArrayList<Rectangle> bs = sectionBounds.get(z);
-			if (null == bs || bs.isEmpty()) continue;
+		// Cut the rectangles of each z into tiles of about TILE_CUBES cubes, so
+		// that large and small rectangles balance over the threads; Z paddings
+		// on top and bottom
+		final List<Integer> tileZ = new ArrayList<Integer>();
+		final List<Rectangle> tiles = new ArrayList<Rectangle>();
+		long nCubes = 0;
+		for (int z = -1; z < car.d + 1 && n > 0; z += 1) {
+			final List<Rectangle> bs = sectionBounds[Math.max(0, Math.min(z, n - 1))];
+			if (null == bs) continue;
 			for (final Rectangle bounds : bs) {
-				for (int x = bounds.x - 1; x < bounds.x + bounds.width + 2; x += 1) {
-					for (int y = bounds.y - 1; y < bounds.y + bounds.height + 2; y += 1) {
-						cube.init(x, y, z);
-						cube.computeEdges(car);
-						cube.getTriangles(tri, car);
+				final int rows = Math.max(1, TILE_CUBES / Math.max(1, bounds.width));
+				for (int y = bounds.y; y < bounds.y + bounds.height; y += rows) {
+					tileZ.add(z);
+					tiles.add(new Rectangle(bounds.x, y, bounds.width,
+						Math.min(rows, bounds.y + bounds.height - y)));
+				}
+				nCubes += (long)bounds.width * bounds.height;
+			}
+		}
+
+		// Scan the tiles on the (work stealing) fork/join pool, each into its
+		// own list, with its own cube
+		final List<Point3f>[] tileTri = new List[tiles.size()];
+		final long totalCubes = Math.max(1, nCubes);
+		final AtomicLong doneCubes = new AtomicLong();
+		final AtomicInteger shownPercent = new AtomicInteger(-1);
+		IntStream.range(0, tiles.size()).parallel().forEach(t -> {
+			final int z = tileZ.get(t);
+			final Rectangle bounds = tiles.get(t);
+			final MCCube c = new MCCube();
+			final List<Point3f> out = new ArrayList<Point3f>();
+			// x inner, since the spans, and thus the cubes skipped, run along x
+			for (int y = bounds.y; y < bounds.y + bounds.height; y += 1) {
+				for (int x = bounds.x; x < bounds.x + bounds.width; x += 1) {
+					// the four rows of the cubes only change at span boundaries:
+					// if they agree at x, the cubes x to next - 2 are all empty
+					// or all full, next being the first boundary after x. The
+					// Carrier reads zero outside [0, w) x [0, h), so this only
+					// holds for rows inside it, and up to its x bounds
+					final int v = volume.load(x, y, z);
+					if (y >= 0 && y + 1 < car.h &&
+						v == volume.load(x, y + 1, z) &&
+						v == volume.load(x, y, z + 1) &&
+						v == volume.load(x, y + 1, z + 1))
+					{
+						int next = Math.min(
+							Math.min(volume.nextBoundary(x, y, z),
+								volume.nextBoundary(x, y + 1, z)),
+							Math.min(volume.nextBoundary(x, y, z + 1),
+								volume.nextBoundary(x, y + 1, z + 1)));
+						next = Math.min(next, x < 0 ? 0 : car.w);
+						if (next >= x + 2) {
+							x = next - 2;
+							continue;
+						}
 					}
+					c.init(x, y, z);
+					c.computeEdges(car);
+					c.getTriangles(out, car);
 				}
 			}
+			tileTri[t] = out;
 
-			IJ.showProgress(z, car.d - 2);
-		}
+			// report progress once per percent, from whichever thread gets there
+			final long done = doneCubes.addAndGet((long)bounds.width * bounds.height);
+			final int percent = (int)(done * 100 / totalCubes);
+			final int shown = shownPercent.get();
+			if (percent > shown && shownPercent.compareAndSet(shown, percent))
+				IJ.showProgress(percent, 100);
+		});
+
+		// the tiles are in z, rectangle, y order
+		for (final List<Point3f> out : tileTri)
+			tri.addAll(out);
 
 		// convert pixel coordinates
 		for (int i = 0; i < tri.size(); i++) {
@@ -329,192 +1540,228 @@ private:
 		return tri;
 	}
 
-protected:
-	const int ambigous[240] = { 250, 245, 237, 231, 222, 219, 189,
-		183, 175, 126, 123, 95, 234, 233, 227, 214, 213, 211, 203, 199, 188, 186,
-		182, 174, 171, 158, 151, 124, 121, 117, 109, 107, 93, 87, 62, 61, 229, 218,
-		181, 173, 167, 122, 94, 91, 150, 170, 195, 135, 149, 154, 163, 166, 169,
-		172, 180, 197, 202, 210, 225, 165 };
+	/**
+	 * Merges rectangles into disjoint ones covering the same cells: the y
+	 * axis is cut at every top and bottom edge, the x intervals within each
+	 * band are merged, and equal intervals of adjacent bands are joined.
+	 *
+	 * @param rects the rectangles, possibly overlapping
+	 * @return the disjoint rectangles
+	 */
+	static List<Rectangle> disjoint(final List<Rectangle> rects) {
+		final List<Rectangle> out = new ArrayList<Rectangle>();
+		if (rects.size() < 2) {
+			out.addAll(rects);
+			return out;
+		}
+		final TreeSet<Integer> cuts = new TreeSet<Integer>();
+		for (final Rectangle r : rects) {
+			cuts.add(r.y);
+			cuts.add(r.y + r.height);
+		}
+		// the rectangles of the previous band, by interval
+		Map<Long, Rectangle> open = new HashMap<Long, Rectangle>();
+		Integer y0 = cuts.first();
+		for (Integer y1 = cuts.higher(y0); y1 != null; y0 = y1, y1 = cuts.higher(y1)) {
+			final List<int[]> intervals = new ArrayList<int[]>();
+			for (final Rectangle r : rects) {
+				if (r.y <= y0 && r.y + r.height >= y1)
+					intervals.add(new int[] { r.x, r.x + r.width });
+			}
+			intervals.sort((a, b) -> Integer.compare(a[0], b[0]));
+			final Map<Long, Rectangle> band = new HashMap<Long, Rectangle>();
+			for (int i = 0; i < intervals.size();) {
+				final int x0 = intervals.get(i)[0];
+				int x1 = intervals.get(i)[1];
+				for (i++; i < intervals.size() && intervals.get(i)[0] <= x1; i++)
+					x1 = Math.max(x1, intervals.get(i)[1]);
+				final long key = ((long)x0 << 32) | (x1 - x0);
+				Rectangle r = open.get(key);
+				if (null != r && r.y + r.height == y0) {
+					r.height = y1 - r.y;
+				}
+				else {
+					r = new Rectangle(x0, y0, x1 - x0, y1 - y0);
+					out.add(r);
+				}
+				band.put(key, r);
+			}
+			open = band;
+		}
+		return out;
+	}
+};
+
+/**
+ * Keeps the triangles of a volume per brick of its min/max pyramid, so that
+ * a change of the threshold from t0 to t1 re-meshes only the bricks whose
+ * intensity range intersects [min(t0, t1), max(t0, t1)], and replaces their
+ * triangles only; the triangles of the other bricks are neither copied nor
+ * moved. The volume (and thus any resampling) and its pyramid are kept for
+ * the lifetime of the context.
+ *
+ * Note that every brick holding triangles at t1 intersects the range, since
+ * the interpolated vertexes move with the threshold; all other bricks hold
+ * no triangles at t0 nor at t1 and are not visited at all.
+ */
+class TriangulationContext {
+
+	//Volume volume;
+	int volume;
+	Carrier car;
+	std::shared_ptr<MinMaxPyramid> pyramid;
+	int nThreads;
+
+	// whether the mesh was computed yet, and for which threshold
+	bool initialized;
+	float threshold;
+
+	// the (calibrated) triangles of each non-empty brick
+	std::map<size_t, std::vector<vec3>> bricks;
+
+public:
+	/**
+	 * The triangles of all bricks, in brick order, as a read-only list of
+	 * points (three per triangle) over the storage of the context, which is
+	 * not copied. It is valid until the next call of getMesh() or
+	 * getTriangles(), and must not be handed to code which keeps it.
+	 */
+	class Mesh {
+	public:
+		/** the number of points */
+		size_t size() const {
+			return offsets.back();
+		}
+
+		/** the point i */
+		const vec3& operator[](size_t i) const {
+			const size_t k = std::upper_bound(offsets.begin(), offsets.end(), i) -
+				offsets.begin() - 1;
+			return (*meshes[k])[i - offsets[k]];
+		}
+
+		/** calls f(points, n) with the points of each brick, in order */
+		template <typename F>
+		void forEachBrick(F f) const {
+			for (size_t k = 0; k < meshes.size(); k++)
+				f((const vec3*)meshes[k]->data(), meshes[k]->size());
+		}
+
+	private:
+		friend class TriangulationContext;
+		std::vector<const std::vector<vec3>*> meshes;
+		// the index of the first point of each mesh, and the size
+		std::vector<size_t> offsets = std::vector<size_t>(1, 0);
+	};
+
+private:
+	Mesh mesh;
+
+public:
+	/**
+	 * @param volume
+	 * @param nThreads number of worker threads; if <= 0, one per hardware
+	 *          thread is used
+	 */
+	TriangulationContext(
+		//Volume volume,
+		int volume,
+		int nThreads = 0)
+		: volume(volume), initialized(false), threshold(0)
+	{
+		car = MCCube::createCarrier(volume, 0);
+		// the pyramid of the volume, with its brick size (see
+		// Volume.setBrickSize()), also used by createCarrier()
+		pyramid = volume.getMinMaxPyramid();
+		car.pyramid = pyramid.get();
+
+		if (nThreads <= 0)
+			nThreads = (int)std::thread::hardware_concurrency();
+		this->nThreads = std::max(1, nThreads);
+	}
+
+	/**
+	 * Returns the triangles for the given isovalue as a list of its own,
+	 * which the caller may keep and change; see getMesh().
+	 */
+	std::vector<vec3> getTriangles(int thresh) {
+		const Mesh& m = getMesh(thresh);
+		std::vector<vec3> tri;
+		tri.reserve(m.size());
+		m.forEachBrick([&tri](const vec3* points, size_t n) {
+			tri.insert(tri.end(), points, points + n);
+		});
+		return tri;
+	}
+
+	/**
+	 * Returns the triangles for the given isovalue, updating only the bricks
+	 * affected by the change from the previous isovalue, as a read-only view
+	 * (see Mesh). The triangles are the ones of MCCube.getTriangles(),
+	 * grouped by brick.
+	 */
+	const Mesh& getMesh(int thresh) {
+		const float t1 = thresh + 0.5f;
+		if (initialized && t1 == threshold)
+			return mesh;
+
+		std::vector<size_t> update;
+		if (initialized)
+			pyramid->bricksInRange(std::min(threshold, t1),
+				std::max(threshold, t1), update);
+		else
+			pyramid->bricksInRange(t1, t1, update);
+		car.threshold = t1;
+
+		// re-mesh the bricks straddling t1, each worker in its own buffers
+		std::vector<std::vector<vec3>> meshes(update.size());
+		const int n = std::max(1, std::min(nThreads, (int)update.size()));
+		std::vector<std::thread> workers;
+		for (int w = 0; w < n; w++) {
+			const size_t begin = update.size() * w / n;
+			const size_t end = update.size() * (w + 1) / n;
+			workers.push_back(std::thread([this, &update, &meshes, begin, end]() {
+				Carrier own = car;
+				for (size_t k = begin; k < end; k++)
+					triangulateBrick(own, update[k], meshes[k]);
+			}));
+		}
+		for (size_t w = 0; w < workers.size(); w++)
+			workers[w].join();
+
+		// replace the meshes of the updated bricks
+		for (size_t k = 0; k < update.size(); k++) {
+			if (meshes[k].empty())
+				bricks.erase(update[k]);
+			else
+				bricks[update[k]].swap(meshes[k]);
+		}
+		mesh.meshes.clear();
+		mesh.offsets.resize(1);
+		for (std::map<size_t, std::vector<vec3>>::const_iterator it =
+			bricks.begin(); it != bricks.end(); ++it)
+		{
+			mesh.meshes.push_back(&it->second);
+			mesh.offsets.push_back(mesh.offsets.back() + it->second.size());
+		}
+
+		threshold = t1;
+		initialized = true;
+		return mesh;
+	}
 
-	// triangles to be drawn in each case
 private:
-	const int faces[15360] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-		-1, -1, -1, -1, -1, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-		-1, 0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 8, 3, 9, 8,
-		1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 2, 11, -1, -1, -1, -1, -1, -1,
-		-1, -1, -1, -1, -1, -1, 0, 8, 3, 1, 2, 11, -1, -1, -1, -1, -1, -1, -1, -1,
-		-1, 9, 2, 11, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 8, 3, 2, 11,
-		8, 11, 9, 8, -1, -1, -1, -1, -1, -1, 3, 10, 2, -1, -1, -1, -1, -1, -1, -1,
-		-1, -1, -1, -1, -1, 0, 10, 2, 8, 10, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-		1, 9, 0, 2, 3, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 10, 2, 1, 9, 10,
-		9, 8, 10, -1, -1, -1, -1, -1, -1, 3, 11, 1, 10, 11, 3, -1, -1, -1, -1, -1,
-		-1, -1, -1, -1, 0, 11, 1, 0, 8, 11, 8, 10, 11, -1, -1, -1, -1, -1, -1, 3,
-		9, 0, 3, 10, 9, 10, 11, 9, -1, -1, -1, -1, -1, -1, 9, 8, 11, 11, 8, 10, -1,
-		-1, -1, -1, -1, -1, -1, -1, -1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1,
-		-1, -1, -1, -1, 4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 1,
-		9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, 4, 1, 9, 4, 7, 1, 7, 3, 1,
-		-1, -1, -1, -1, -1, -1, 1, 2, 11, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1,
-		-1, 3, 4, 7, 3, 0, 4, 1, 2, 11, -1, -1, -1, -1, -1, -1, 9, 2, 11, 9, 0, 2,
-		8, 4, 7, -1, -1, -1, -1, -1, -1, 2, 11, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1,
-		-1, -1, 8, 4, 7, 3, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, 10, 4, 7,
-		10, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, 9, 0, 1, 8, 4, 7, 2, 3, 10, -1,
-		-1, -1, -1, -1, -1, 4, 7, 10, 9, 4, 10, 9, 10, 2, 9, 2, 1, -1, -1, -1, 3,
-		11, 1, 3, 10, 11, 7, 8, 4, -1, -1, -1, -1, -1, -1, 1, 10, 11, 1, 4, 10, 1,
-		0, 4, 7, 10, 4, -1, -1, -1, 4, 7, 8, 9, 0, 10, 9, 10, 11, 10, 0, 3, -1, -1,
-		-1, 4, 7, 10, 4, 10, 9, 9, 10, 11, -1, -1, -1, -1, -1, -1, 9, 5, 4, -1, -1,
-		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, 5, 4, 0, 8, 3, -1, -1, -1, -1,
-		-1, -1, -1, -1, -1, 0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-		8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, 1, 2, 11, 9, 5, 4, -1,
-		-1, -1, -1, -1, -1, -1, -1, -1, 3, 0, 8, 1, 2, 11, 4, 9, 5, -1, -1, -1, -1,
-		-1, -1, 5, 2, 11, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, 2, 11, 5, 3, 2,
-		5, 3, 5, 4, 3, 4, 8, -1, -1, -1, 9, 5, 4, 2, 3, 10, -1, -1, -1, -1, -1, -1,
-		-1, -1, -1, 0, 10, 2, 0, 8, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, 0, 5, 4,
-		0, 1, 5, 2, 3, 10, -1, -1, -1, -1, -1, -1, 2, 1, 5, 2, 5, 8, 2, 8, 10, 4,
-		8, 5, -1, -1, -1, 11, 3, 10, 11, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, 4,
-		9, 5, 0, 8, 1, 8, 11, 1, 8, 10, 11, -1, -1, -1, 5, 4, 0, 5, 0, 10, 5, 10,
-		11, 10, 0, 3, -1, -1, -1, 5, 4, 8, 5, 8, 11, 11, 8, 10, -1, -1, -1, -1, -1,
-		-1, 9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, 3, 0, 9, 5, 3,
-		5, 7, 3, -1, -1, -1, -1, -1, -1, 0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1,
-		-1, -1, 1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, 7, 8, 9,
-		5, 7, 11, 1, 2, -1, -1, -1, -1, -1, -1, 11, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7,
-		3, -1, -1, -1, 8, 0, 2, 8, 2, 5, 8, 5, 7, 11, 5, 2, -1, -1, -1, 2, 11, 5,
-		2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, 7, 9, 5, 7, 8, 9, 3, 10, 2, -1,
-		-1, -1, -1, -1, -1, 9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 10, -1, -1, -1, 2, 3,
-		10, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, 10, 2, 1, 10, 1, 7, 7, 1, 5, -1,
-		-1, -1, -1, -1, -1, 9, 5, 8, 8, 5, 7, 11, 1, 3, 11, 3, 10, -1, -1, -1, 5,
-		7, 0, 5, 0, 9, 7, 10, 0, 1, 0, 11, 10, 11, 0, 10, 11, 0, 10, 0, 3, 11, 5,
-		0, 8, 0, 7, 5, 7, 0, 10, 11, 5, 7, 10, 5, -1, -1, -1, -1, -1, -1, -1, -1,
-		-1, 11, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 8, 3, 5,
-		11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, 0, 1, 5, 11, 6, -1, -1, -1,
-		-1, -1, -1, -1, -1, -1, 1, 8, 3, 1, 9, 8, 5, 11, 6, -1, -1, -1, -1, -1, -1,
-		1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 6, 5, 1, 2, 6, 3,
-		0, 8, -1, -1, -1, -1, -1, -1, 9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1,
-		-1, -1, 5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, 2, 3, 10, 11, 6, 5,
-		-1, -1, -1, -1, -1, -1, -1, -1, -1, 10, 0, 8, 10, 2, 0, 11, 6, 5, -1, -1,
-		-1, -1, -1, -1, 0, 1, 9, 2, 3, 10, 5, 11, 6, -1, -1, -1, -1, -1, -1, 5, 11,
-		6, 1, 9, 2, 9, 10, 2, 9, 8, 10, -1, -1, -1, 6, 3, 10, 6, 5, 3, 5, 1, 3, -1,
-		-1, -1, -1, -1, -1, 0, 8, 10, 0, 10, 5, 0, 5, 1, 5, 10, 6, -1, -1, -1, 3,
-		10, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, 6, 5, 9, 6, 9, 10, 10, 9, 8,
-		-1, -1, -1, -1, -1, -1, 5, 11, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1,
-		-1, 4, 3, 0, 4, 7, 3, 6, 5, 11, -1, -1, -1, -1, -1, -1, 1, 9, 0, 5, 11, 6,
-		8, 4, 7, -1, -1, -1, -1, -1, -1, 11, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1,
-		-1, -1, 6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, 1, 2, 5, 5, 2,
-		6, 3, 0, 4, 3, 4, 7, -1, -1, -1, 8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1,
-		-1, -1, 7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, 3, 10, 2, 7, 8, 4, 11,
-		6, 5, -1, -1, -1, -1, -1, -1, 5, 11, 6, 4, 7, 2, 4, 2, 0, 2, 7, 10, -1, -1,
-		-1, 0, 1, 9, 4, 7, 8, 2, 3, 10, 5, 11, 6, -1, -1, -1, 9, 2, 1, 9, 10, 2, 9,
-		4, 10, 7, 10, 4, 5, 11, 6, 8, 4, 7, 3, 10, 5, 3, 5, 1, 5, 10, 6, -1, -1,
-		-1, 5, 1, 10, 5, 10, 6, 1, 0, 10, 7, 10, 4, 0, 4, 10, 0, 5, 9, 0, 6, 5, 0,
-		3, 6, 10, 6, 3, 8, 4, 7, 6, 5, 9, 6, 9, 10, 4, 7, 9, 7, 10, 9, -1, -1, -1,
-		11, 4, 9, 6, 4, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, 4, 11, 6, 4, 9, 11,
-		0, 8, 3, -1, -1, -1, -1, -1, -1, 11, 0, 1, 11, 6, 0, 6, 4, 0, -1, -1, -1,
-		-1, -1, -1, 8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 11, -1, -1, -1, 1, 4, 9, 1, 2,
-		4, 2, 6, 4, -1, -1, -1, -1, -1, -1, 3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1,
-		-1, -1, 0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, 8, 3, 2, 8,
-		2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, 11, 4, 9, 11, 6, 4, 10, 2, 3, -1,
-		-1, -1, -1, -1, -1, 0, 8, 2, 2, 8, 10, 4, 9, 11, 4, 11, 6, -1, -1, -1, 3,
-		10, 2, 0, 1, 6, 0, 6, 4, 6, 1, 11, -1, -1, -1, 6, 4, 1, 6, 1, 11, 4, 8, 1,
-		2, 1, 10, 8, 10, 1, 9, 6, 4, 9, 3, 6, 9, 1, 3, 10, 6, 3, -1, -1, -1, 8, 10,
-		1, 8, 1, 0, 10, 6, 1, 9, 1, 4, 6, 4, 1, 3, 10, 6, 3, 6, 0, 0, 6, 4, -1, -1,
-		-1, -1, -1, -1, 6, 4, 8, 10, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, 7,
-		11, 6, 7, 8, 11, 8, 9, 11, -1, -1, -1, -1, -1, -1, 0, 7, 3, 0, 11, 7, 0, 9,
-		11, 6, 7, 11, -1, -1, -1, 11, 6, 7, 1, 11, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1,
-		11, 6, 7, 11, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, 1, 2, 6, 1, 6, 8, 1,
-		8, 9, 8, 6, 7, -1, -1, -1, 2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, 7,
-		8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, 7, 3, 2, 6, 7, 2, -1, -1,
-		-1, -1, -1, -1, -1, -1, -1, 2, 3, 10, 11, 6, 8, 11, 8, 9, 8, 6, 7, -1, -1,
-		-1, 2, 0, 7, 2, 7, 10, 0, 9, 7, 6, 7, 11, 9, 11, 7, 1, 8, 0, 1, 7, 8, 1,
-		11, 7, 6, 7, 11, 2, 3, 10, 10, 2, 1, 10, 1, 7, 11, 6, 1, 6, 7, 1, -1, -1,
-		-1, 8, 9, 6, 8, 6, 7, 9, 1, 6, 10, 6, 3, 1, 3, 6, 0, 9, 1, 10, 6, 7, -1,
-		-1, -1, -1, -1, -1, -1, -1, -1, 7, 8, 0, 7, 0, 6, 3, 10, 0, 10, 6, 0, -1,
-		-1, -1, 7, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 7, 6, 10,
-		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 3, 0, 8, 10, 7, 6, -1, -1,
-		-1, -1, -1, -1, -1, -1, -1, 0, 1, 9, 10, 7, 6, -1, -1, -1, -1, -1, -1, -1,
-		-1, -1, 8, 1, 9, 8, 3, 1, 10, 7, 6, -1, -1, -1, -1, -1, -1, 11, 1, 2, 6,
-		10, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 2, 11, 3, 0, 8, 6, 10, 7, -1,
-		-1, -1, -1, -1, -1, 2, 9, 0, 2, 11, 9, 6, 10, 7, -1, -1, -1, -1, -1, -1, 6,
-		10, 7, 2, 11, 3, 11, 8, 3, 11, 9, 8, -1, -1, -1, 7, 2, 3, 6, 2, 7, -1, -1,
-		-1, -1, -1, -1, -1, -1, -1, 7, 0, 8, 7, 6, 0, 6, 2, 0, -1, -1, -1, -1, -1,
-		-1, 2, 7, 6, 2, 3, 7, 0, 1, 9, -1, -1, -1, -1, -1, -1, 1, 6, 2, 1, 8, 6, 1,
-		9, 8, 8, 7, 6, -1, -1, -1, 11, 7, 6, 11, 1, 7, 1, 3, 7, -1, -1, -1, -1, -1,
-		-1, 11, 7, 6, 1, 7, 11, 1, 8, 7, 1, 0, 8, -1, -1, -1, 0, 3, 7, 0, 7, 11, 0,
-		11, 9, 6, 11, 7, -1, -1, -1, 7, 6, 11, 7, 11, 8, 8, 11, 9, -1, -1, -1, -1,
-		-1, -1, 6, 8, 4, 10, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, 3, 6, 10, 3,
-		0, 6, 0, 4, 6, -1, -1, -1, -1, -1, -1, 8, 6, 10, 8, 4, 6, 9, 0, 1, -1, -1,
-		-1, -1, -1, -1, 9, 4, 6, 9, 6, 3, 9, 3, 1, 10, 3, 6, -1, -1, -1, 6, 8, 4,
-		6, 10, 8, 2, 11, 1, -1, -1, -1, -1, -1, -1, 1, 2, 11, 3, 0, 10, 0, 6, 10,
-		0, 4, 6, -1, -1, -1, 4, 10, 8, 4, 6, 10, 0, 2, 9, 2, 11, 9, -1, -1, -1, 11,
-		9, 3, 11, 3, 2, 9, 4, 3, 10, 3, 6, 4, 6, 3, 8, 2, 3, 8, 4, 2, 4, 6, 2, -1,
-		-1, -1, -1, -1, -1, 0, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-		1, 9, 0, 2, 3, 4, 2, 4, 6, 4, 3, 8, -1, -1, -1, 1, 9, 4, 1, 4, 2, 2, 4, 6,
-		-1, -1, -1, -1, -1, -1, 8, 1, 3, 8, 6, 1, 8, 4, 6, 6, 11, 1, -1, -1, -1,
-		11, 1, 0, 11, 0, 6, 6, 0, 4, -1, -1, -1, -1, -1, -1, 4, 6, 3, 4, 3, 8, 6,
-		11, 3, 0, 3, 9, 11, 9, 3, 11, 9, 4, 6, 11, 4, -1, -1, -1, -1, -1, -1, -1,
-		-1, -1, 4, 9, 5, 7, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 8, 3, 4,
-		9, 5, 10, 7, 6, -1, -1, -1, -1, -1, -1, 5, 0, 1, 5, 4, 0, 7, 6, 10, -1, -1,
-		-1, -1, -1, -1, 10, 7, 6, 8, 3, 4, 3, 5, 4, 3, 1, 5, -1, -1, -1, 9, 5, 4,
-		11, 1, 2, 7, 6, 10, -1, -1, -1, -1, -1, -1, 6, 10, 7, 1, 2, 11, 0, 8, 3, 4,
-		9, 5, -1, -1, -1, 7, 6, 10, 5, 4, 11, 4, 2, 11, 4, 0, 2, -1, -1, -1, 3, 4,
-		8, 3, 5, 4, 3, 2, 5, 11, 5, 2, 10, 7, 6, 7, 2, 3, 7, 6, 2, 5, 4, 9, -1, -1,
-		-1, -1, -1, -1, 9, 5, 4, 0, 8, 6, 0, 6, 2, 6, 8, 7, -1, -1, -1, 3, 6, 2, 3,
-		7, 6, 1, 5, 0, 5, 4, 0, -1, -1, -1, 6, 2, 8, 6, 8, 7, 2, 1, 8, 4, 8, 5, 1,
-		5, 8, 9, 5, 4, 11, 1, 6, 1, 7, 6, 1, 3, 7, -1, -1, -1, 1, 6, 11, 1, 7, 6,
-		1, 0, 7, 8, 7, 0, 9, 5, 4, 4, 0, 11, 4, 11, 5, 0, 3, 11, 6, 11, 7, 3, 7,
-		11, 7, 6, 11, 7, 11, 8, 5, 4, 11, 4, 8, 11, -1, -1, -1, 6, 9, 5, 6, 10, 9,
-		10, 8, 9, -1, -1, -1, -1, -1, -1, 3, 6, 10, 0, 6, 3, 0, 5, 6, 0, 9, 5, -1,
-		-1, -1, 0, 10, 8, 0, 5, 10, 0, 1, 5, 5, 6, 10, -1, -1, -1, 6, 10, 3, 6, 3,
-		5, 5, 3, 1, -1, -1, -1, -1, -1, -1, 1, 2, 11, 9, 5, 10, 9, 10, 8, 10, 5, 6,
-		-1, -1, -1, 0, 10, 3, 0, 6, 10, 0, 9, 6, 5, 6, 9, 1, 2, 11, 10, 8, 5, 10,
-		5, 6, 8, 0, 5, 11, 5, 2, 0, 2, 5, 6, 10, 3, 6, 3, 5, 2, 11, 3, 11, 5, 3,
-		-1, -1, -1, 5, 8, 9, 5, 2, 8, 5, 6, 2, 3, 8, 2, -1, -1, -1, 9, 5, 6, 9, 6,
-		0, 0, 6, 2, -1, -1, -1, -1, -1, -1, 1, 5, 8, 1, 8, 0, 5, 6, 8, 3, 8, 2, 6,
-		2, 8, 1, 5, 6, 2, 1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 3, 6, 1, 6,
-		11, 3, 8, 6, 5, 6, 9, 8, 9, 6, 11, 1, 0, 11, 0, 6, 9, 5, 0, 5, 6, 0, -1,
-		-1, -1, 0, 3, 8, 5, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, 11, 5, 6,
-		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 10, 5, 11, 7, 5, 10, -1,
-		-1, -1, -1, -1, -1, -1, -1, -1, 10, 5, 11, 10, 7, 5, 8, 3, 0, -1, -1, -1,
-		-1, -1, -1, 5, 10, 7, 5, 11, 10, 1, 9, 0, -1, -1, -1, -1, -1, -1, 11, 7, 5,
-		11, 10, 7, 9, 8, 1, 8, 3, 1, -1, -1, -1, 10, 1, 2, 10, 7, 1, 7, 5, 1, -1,
-		-1, -1, -1, -1, -1, 0, 8, 3, 1, 2, 7, 1, 7, 5, 7, 2, 10, -1, -1, -1, 9, 7,
-		5, 9, 2, 7, 9, 0, 2, 2, 10, 7, -1, -1, -1, 7, 5, 2, 7, 2, 10, 5, 9, 2, 3,
-		2, 8, 9, 8, 2, 2, 5, 11, 2, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, 8, 2, 0,
-		8, 5, 2, 8, 7, 5, 11, 2, 5, -1, -1, -1, 9, 0, 1, 5, 11, 3, 5, 3, 7, 3, 11,
-		2, -1, -1, -1, 9, 8, 2, 9, 2, 1, 8, 7, 2, 11, 2, 5, 7, 5, 2, 1, 3, 5, 3, 7,
-		5, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 8, 7, 0, 7, 1, 1, 7, 5, -1, -1,
-		-1, -1, -1, -1, 9, 0, 3, 9, 3, 5, 5, 3, 7, -1, -1, -1, -1, -1, -1, 9, 8, 7,
-		5, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, 5, 8, 4, 5, 11, 8, 11, 10, 8,
-		-1, -1, -1, -1, -1, -1, 5, 0, 4, 5, 10, 0, 5, 11, 10, 10, 3, 0, -1, -1, -1,
-		0, 1, 9, 8, 4, 11, 8, 11, 10, 11, 4, 5, -1, -1, -1, 11, 10, 4, 11, 4, 5,
-		10, 3, 4, 9, 4, 1, 3, 1, 4, 2, 5, 1, 2, 8, 5, 2, 10, 8, 4, 5, 8, -1, -1,
-		-1, 0, 4, 10, 0, 10, 3, 4, 5, 10, 2, 10, 1, 5, 1, 10, 0, 2, 5, 0, 5, 9, 2,
-		10, 5, 4, 5, 8, 10, 8, 5, 9, 4, 5, 2, 10, 3, -1, -1, -1, -1, -1, -1, -1,
-		-1, -1, 2, 5, 11, 3, 5, 2, 3, 4, 5, 3, 8, 4, -1, -1, -1, 5, 11, 2, 5, 2, 4,
-		4, 2, 0, -1, -1, -1, -1, -1, -1, 3, 11, 2, 3, 5, 11, 3, 8, 5, 4, 5, 8, 0,
-		1, 9, 5, 11, 2, 5, 2, 4, 1, 9, 2, 9, 4, 2, -1, -1, -1, 8, 4, 5, 8, 5, 3, 3,
-		5, 1, -1, -1, -1, -1, -1, -1, 0, 4, 5, 1, 0, 5, -1, -1, -1, -1, -1, -1, -1,
-		-1, -1, 8, 4, 5, 8, 5, 3, 9, 0, 5, 0, 3, 5, -1, -1, -1, 9, 4, 5, -1, -1,
-		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 4, 10, 7, 4, 9, 10, 9, 11, 10, -1,
-		-1, -1, -1, -1, -1, 0, 8, 3, 4, 9, 7, 9, 10, 7, 9, 11, 10, -1, -1, -1, 1,
-		11, 10, 1, 10, 4, 1, 4, 0, 7, 4, 10, -1, -1, -1, 3, 1, 4, 3, 4, 8, 1, 11,
-		4, 7, 4, 10, 11, 10, 4, 4, 10, 7, 9, 10, 4, 9, 2, 10, 9, 1, 2, -1, -1, -1,
-		9, 7, 4, 9, 10, 7, 9, 1, 10, 2, 10, 1, 0, 8, 3, 10, 7, 4, 10, 4, 2, 2, 4,
-		0, -1, -1, -1, -1, -1, -1, 10, 7, 4, 10, 4, 2, 8, 3, 4, 3, 2, 4, -1, -1,
-		-1, 2, 9, 11, 2, 7, 9, 2, 3, 7, 7, 4, 9, -1, -1, -1, 9, 11, 7, 9, 7, 4, 11,
-		2, 7, 8, 7, 0, 2, 0, 7, 3, 7, 11, 3, 11, 2, 7, 4, 11, 1, 11, 0, 4, 0, 11,
-		1, 11, 2, 8, 7, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, 4, 9, 1, 4, 1, 7, 7,
-		1, 3, -1, -1, -1, -1, -1, -1, 4, 9, 1, 4, 1, 7, 0, 8, 1, 8, 7, 1, -1, -1,
-		-1, 4, 0, 3, 7, 4, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, 4, 8, 7, -1, -1,
-		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, 11, 8, 11, 10, 8, -1, -1, -1,
-		-1, -1, -1, -1, -1, -1, 3, 0, 9, 3, 9, 10, 10, 9, 11, -1, -1, -1, -1, -1,
-		-1, 0, 1, 11, 0, 11, 8, 8, 11, 10, -1, -1, -1, -1, -1, -1, 3, 1, 11, 10, 3,
-		11, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 2, 10, 1, 10, 9, 9, 10, 8, -1,
-		-1, -1, -1, -1, -1, 3, 0, 9, 3, 9, 10, 1, 2, 9, 2, 10, 9, -1, -1, -1, 0, 2,
-		10, 8, 0, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, 3, 2, 10, -1, -1, -1, -1,
-		-1, -1, -1, -1, -1, -1, -1, -1, 2, 3, 8, 2, 8, 11, 11, 8, 9, -1, -1, -1,
-		-1, -1, -1, 9, 11, 2, 0, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 3, 8,
-		2, 8, 11, 0, 1, 8, 1, 11, 8, -1, -1, -1, 1, 11, 2, -1, -1, -1, -1, -1, -1,
-		-1, -1, -1, -1, -1, -1, 1, 3, 8, 9, 1, 8, -1, -1, -1, -1, -1, -1, -1, -1,
-		-1, 0, 9, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 8, -1,
-		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-		-1, -1, -1, -1, -1, -1, -1 };
+	void triangulateBrick(Carrier& car, size_t brick, std::vector<vec3>& tri) {
+		const MinMaxPyramid::Level& l0 = pyramid->levels[0];
+		if (!pyramid->straddles(0, (int)(brick % l0.nx),
+			(int)(brick / l0.nx % l0.ny), (int)(brick / l0.nx / l0.ny), car.threshold))
+			return;
+		const int b = pyramid->brickSize;
+		const int x0 = (int)(brick % l0.nx) * b - 1;
+		const int y0 = (int)(brick / l0.nx % l0.ny) * b - 1;
+		const int z0 = (int)(brick / l0.nx / l0.ny) * b - 1;
+		MCCube::getTriangles(car, x0, y0, z0, std::min(x0 + b, car.w + 1),
+			std::min(y0 + b, car.h + 1), std::min(z0 + b, car.d + 1), tri);
+		MCCube::convertCoordinates(tri, volume);
+	}
 };
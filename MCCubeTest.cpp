@@ -0,0 +1,184 @@
+/**
+ * Tests of MCCube. The volume is N x N x N voxels, a blurred sphere with
+ * some spikes, read by the Carrier::intensity() defined here. Build it
+ * once as is and once with AVX2 enabled, to test both vectorized paths.
+ */
+
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "thirdparties/include/glm/vec3.hpp"
+#include "Carrier.hpp"
+
+// odd, so that no row of cubes is a multiple of a vector width
+static const int N = 23;
+static std::vector<int> voxels;
+
+int Carrier::intensity(glm::vec3 p) const {
+	if (p.x < 0 || p.y < 0 || p.z < 0 || p.x >= w || p.y >= h || p.z >= d)
+		return 0;
+	return voxels[((int)p.z * N + (int)p.y) * N + (int)p.x];
+}
+
+#include "MCCube.cpp"
+
+static int failures = 0;
+
+/** reports a failure of what, for the threshold or length k */
+static void check(bool ok, const char* what, int k) {
+	if (!ok) {
+		std::printf("FAILED: %s (%d)\n", what, k);
+		failures++;
+	}
+}
+
+static void makeVolume() {
+	voxels.resize((size_t)N * N * N);
+	for (int z = 0; z < N; z++)
+		for (int y = 0; y < N; y++)
+			for (int x = 0; x < N; x++) {
+				const float dx = x - 10.5f, dy = y - 9.0f, dz = z - 7.0f;
+				const float r = std::sqrt(dx * dx + dy * dy + dz * dz);
+				voxels[((size_t)z * N + y) * N + x] = (int)std::fmax(0.f,
+					255 - 20 * r) + ((x * 7 + y * 3 + z) % 5 == 0 ? 60 : 0);
+			}
+}
+
+/**
+ * getIndexedTriangles() gives the triangles of getTriangles(), in the same
+ * order, with every distinct point stored once.
+ */
+static void testIndexedTriangles(int thresh) {
+	const std::vector<vec3> tri = MCCube::getTriangles(N, thresh);
+	std::vector<vec3> vertices;
+	std::vector<uint32_t> indices;
+	MCCube::getIndexedTriangles(N, thresh, vertices, indices);
+
+	check(indices.size() == tri.size(), "one index per point", thresh);
+	bool same = indices.size() == tri.size();
+	for (size_t i = 0; i < indices.size() && same; i++)
+		same = indices[i] < vertices.size() && vertices[indices[i]] == tri[i];
+	check(same, "the indexed points are the triangles", thresh);
+
+	std::set<std::tuple<float, float, float>> distinct;
+	for (size_t i = 0; i < tri.size(); i++)
+		distinct.insert(std::make_tuple(tri[i].x, tri[i].y, tri[i].z));
+	check(vertices.size() == distinct.size(), "each point stored once", thresh);
+}
+
+/**
+ * The vectorized (SSE2 or AVX2, whichever MCCube was built with) compare()
+ * and classify() of the slice cache against their scalar definitions, for
+ * all lengths up to a few vectors, and the sweep against a scan of every
+ * cube, which computes each case from the eight intensities.
+ */
+class MCCubeTest {
+public:
+	typedef MCCube::SliceCache SliceCache;
+	typedef MCCube::BasicSliceCache<float> FloatSliceCache;
+
+	static void testCompare() {
+		std::srand(2);
+		for (int n = 0; n <= 100; n++) {
+			std::vector<int> ints(n + SliceCache::PADDING);
+			std::vector<float> floats(n + SliceCache::PADDING);
+			for (int i = 0; i < n; i++) {
+				ints[i] = std::rand() % 601 - 300;
+				floats[i] = ints[i] / 3.0f;
+			}
+			if (n > 3) {
+				ints[0] = INT_MIN;
+				ints[n - 1] = INT_MAX;
+				floats[0] = std::numeric_limits<float>::quiet_NaN();
+				floats[1] = -0.0f;
+				floats[n - 1] = std::numeric_limits<float>::infinity();
+			}
+			const int its[] = { INT_MIN, -1, 0, 100, INT_MAX - 1 };
+			for (int t : its) {
+				std::vector<unsigned char> above(n + SliceCache::PADDING, 7);
+				SliceCache::compare(ints.data(), above.data(), n, t);
+				bool same = true;
+				for (int i = 0; i < n; i++)
+					same = same && above[i] == (ints[i] > t ? 1 : 0);
+				check(same, "int compare", t);
+			}
+			const float fts[] = { -1e30f, -0.0f, 0.0f, 33.4f, 100.0f };
+			for (float t : fts) {
+				std::vector<unsigned char> above(n + SliceCache::PADDING, 7);
+				FloatSliceCache::compare(floats.data(), above.data(), n, t);
+				bool same = true;
+				for (int i = 0; i < n; i++)
+					same = same && above[i] == (floats[i] > t ? 1 : 0);
+				check(same, "float compare", (int)t);
+			}
+		}
+	}
+
+	static void testClassify() {
+		std::srand(3);
+		for (int n = 0; n <= 100; n++) {
+			const int stride = 1 + std::rand() % 40;
+			const size_t size = n + stride + 1 + SliceCache::PADDING;
+			std::vector<unsigned char> a0(size), a1(size);
+			// runs of zeros, of ones, and noise, so that all kinds of cases occur
+			for (size_t i = 0; i < size; i++) {
+				const int kind = (int)(i / 9 % 3);
+				a0[i] = kind == 2 ? std::rand() & 1 : kind;
+				a1[i] = kind == 2 ? std::rand() & 1 : kind;
+			}
+			std::vector<unsigned char> cases(n + SliceCache::PADDING);
+			std::vector<int> active;
+			SliceCache::classify(a0.data(), a1.data(), stride, cases.data(), n,
+				1000, active);
+
+			std::vector<int> expected;
+			bool same = true;
+			for (int i = 0; i < n; i++) {
+				const int c = a0[i] | a0[i + stride] << 1 |
+					a0[i + stride + 1] << 2 | a0[i + 1] << 3 | a1[i] << 4 |
+					a1[i + stride] << 5 | a1[i + stride + 1] << 6 | a1[i + 1] << 7;
+				same = same && cases[i] == c;
+				if (c != 0 && c != 255) expected.push_back(1000 + i);
+			}
+			check(same, "case numbers", n);
+			check(active == expected, "active cubes", n);
+		}
+	}
+
+	static void testSweep(int thresh) {
+		const std::vector<vec3> tri = MCCube::getTriangles(N, thresh);
+
+		// every cube, its case from the Carrier
+		Carrier car = MCCube::createCarrier(N, thresh);
+		MCCube cube;
+		std::vector<vec3> all;
+		for (int z = -1; z < car.d + 1; z++)
+			for (int x = -1; x < car.w + 1; x++)
+				for (int y = -1; y < car.h + 1; y++) {
+					cube.init(x, y, z);
+					cube.computeEdges(car);
+					cube.getTriangles(all, car);
+				}
+		MCCube::convertCoordinates(all, N);
+		check(tri == all, "the sweep gives the triangles of all cubes", thresh);
+	}
+};
+
+int main() {
+	makeVolume();
+	const int thresholds[] = { 0, 50, 100, 200, 254, 300 };
+	for (int t : thresholds)
+		testIndexedTriangles(t);
+	MCCubeTest::testCompare();
+	MCCubeTest::testClassify();
+	for (int t : thresholds)
+		MCCubeTest::testSweep(t);
+	if (failures == 0) std::printf("MCCubeTest: passed\n");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+/**
+ * Tests of MCTables: the compile time tables caseTable and ambigousCases
+ * must give the triangles and the ambigous cases found by walking faces and
+ * ambigous at run time, as MCCube used to.
+ */
+
+#include <cstdio>
+
+#include "MCTables.hpp"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, int cn) {
+	if (!ok) {
+		std::printf("FAILED: %s (case %d)\n", what, cn);
+		failures++;
+	}
+}
+
+int main() {
+	for (int cn = 0; cn < 256; cn++) {
+		const MCTables::Case& c = MCTables::caseTable[cn];
+
+		// the triangles of the case, at run time from faces
+		int count = 0;
+		bool same = true;
+		for (int offset = cn * 15; offset < cn * 15 + 15; offset += 3) {
+			if (MCTables::faces[offset] == -1) continue;
+			for (int k = 0; k < 3; k++)
+				same = same && 3 * count + k < 15 &&
+					c.edges[3 * count + k] == MCTables::faces[offset + k];
+			count++;
+		}
+		check(c.count == count, "triangle count", cn);
+		check(same, "edges of the triangles", cn);
+		for (int i = 3 * c.count; i < 15; i++)
+			check(c.edges[i] == -1, "padding", cn);
+
+		bool ambigous = false;
+		for (int i = 0; i < (int)sizeof(MCTables::ambigous); i++)
+			ambigous = ambigous || MCTables::ambigous[i] == cn;
+		check(MCTables::ambigousCases.contains(cn) == ambigous, "ambigous", cn);
+	}
+	if (failures == 0) std::printf("MCTablesTest: passed\n");
+	return failures == 0 ? 0 : 1;
+}
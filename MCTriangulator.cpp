@@ -22,6 +22,7 @@
 
 package marchingcubes;
 
+import java.util.Arrays;
 import java.util.List;
 
 import org.scijava.vecmath.Point3f;
@@ -35,27 +36,108 @@ import ij.process.ImageProcessor;
 import ij3d.AreaListVolume;
 import ij3d.Volume;
 import isosurface.Triangulator;
-import vib.NaiveResampler;
 
 public class MCTriangulator implements Triangulator {
 
+	/** Classic marching cubes, see {@link MCCube}. */
+	public static final int MARCHING_CUBES = 0;
+
+	/** Flying edges, see {@link FlyingEdges}. */
+	public static final int FLYING_EDGES = 1;
+
+	private int algorithm = MARCHING_CUBES;
+
+	/**
+	 * Selects the isosurface algorithm used by getTriangles(); one of
+	 * MARCHING_CUBES or FLYING_EDGES. Both produce the same triangles.
+	 */
+	public void setAlgorithm(final int algorithm) {
+		this.algorithm = algorithm;
+	}
+
+	public int getAlgorithm() {
+		return algorithm;
+	}
+
+	/*
+	 * The volume of the last call and what it was created from. It is reused
+	 * as long as these do not change (e.g. when only the threshold changes),
+	 * together with its min/max pyramid.
+	 */
+	private Volume volume;
+	private ImagePlus volumeImage;
+	private boolean[] volumeChannels;
+	private int volumeResamplingF;
+
+	/*
+	 * The marching cubes triangles of the volume, per brick; a new threshold
+	 * only re-meshes the bricks whose values lie between the two thresholds.
+	 */
+	private TriangulationContext context;
+
 	@Override
-		public List getTriangles(ImagePlus image, final int threshold,
+		public List getTriangles(final ImagePlus image, final int threshold,
 			final boolean[] channels, final int resamplingF)
 	{
+		final Volume volume = getVolume(image, channels, resamplingF);
+
+		// get triangles
+		if (algorithm == FLYING_EDGES)
+			return FlyingEdges.getTriangles(volume, threshold);
+		if (context == null) context = new TriangulationContext(volume);
+		// a copy: the mesh is kept and changed by CustomTriangleMesh, while
+		// the context re-meshes its bricks on the next call
+		return context.getTriangles(threshold);
+	}
+
+	/**
+	 * Computes the meshes of a level of detail pyramid in one pass over the
+	 * volume, for the resampling factors resamplingF * 2^k, k < nLevels.
+	 *
+	 * @return the mesh for the factor resamplingF * 2^k at index k
+	 */
+	public List<List<Point3f>> getLODTriangles(final ImagePlus image,
+		final int threshold, final boolean[] channels, final int resamplingF,
+		final int nLevels)
+	{
+		final Volume volume = getVolume(image, channels, resamplingF);
+		return MCCube.getLODTriangles(volume, threshold, nLevels);
+	}
+
+	/**
+	 * Triangulates a 16 or 32 bit image on its values as they are, rather
+	 * than reduced to 8 bit or truncated to int, for a float isovalue (see
+	 * MCCube.getNativeTriangles()). Other images are triangulated as by
+	 * getTriangles(), with threshold - 0.5 rounded down.
+	 */
+	public List<Point3f> getNativeTriangles(final ImagePlus image,
+		final float threshold, final boolean[] channels, final int resamplingF)
+	{
+		final Volume volume = getVolume(image, channels, resamplingF);
+		return MCCube.getNativeTriangles(volume, threshold, 0);
+	}
+
+	private Volume getVolume(final ImagePlus image, final boolean[] channels,
+		final int resamplingF)
+	{
+		if (volume != null && image == volumeImage &&
+			Arrays.equals(channels, volumeChannels) &&
+			resamplingF == volumeResamplingF) return volume;
+
+		volumeImage = image;
+		volumeChannels = channels.clone();
+		volumeResamplingF = resamplingF;
+		context = null;
 
-		if (resamplingF != 1) image = NaiveResampler.resample(image, resamplingF);
 		// There is no need to zero pad any more. MCCube automatically
 		// scans one pixel more in each direction, assuming a value
 		// of zero outside the image.
 		// zeroPad(image);
-		// create Volume
-		final Volume volume = new Volume(image, channels);
+		// create Volume, resampled from the pixels of the image, without
+		// an intermediate copy (see Volume.setImage(imp, ch, f))
+		volume = new Volume(image, channels, resamplingF);
 		volume.setAverage(true);
-
-		// get triangles
-		final List l = MCCube.getTriangles(volume, threshold);
-		return l;
+		return volume;
 	}
 
 	/**
@@ -39,11 +39,18 @@ import marchingcubes.MCTriangulator;
 
 public class MeshGroup extends ContentNode {
 
+	/** Number of levels of detail, for the factors 1, 2, 4 and 8. */
+	public static final int LOD_LEVELS = 4;
+
 	private final CustomTriangleMesh mesh;
 	private final Triangulator triangulator = new MCTriangulator();
 	private final ContentInstant c;
 	private Point3f min, max, center;
 
+	/* the meshes of all levels of detail, computed on first use */
+	private List<List<Point3f>> levels;
+	private int level = 0;
+
 	public MeshGroup(final Content c) {
 		this(c.getCurrent());
 	}
@@ -69,6 +76,29 @@ public class MeshGroup extends ContentNode {
 		return mesh;
 	}
 
+	/**
+	 * Shows the coarsest level of detail whose voxels still cover at most
+	 * one pixel on screen, so that the detail it drops is below the pixel
+	 * size, given the on-screen size of a voxel of the full resolution mesh.
+	 * The levels are triangulated once, in a single pass, and reused for
+	 * every later call.
+	 *
+	 * @param pixelsPerVoxel on-screen size of a voxel, in pixels
+	 */
+	public void setPixelsPerVoxel(final double pixelsPerVoxel) {
+		int l = 0;
+		while (l + 1 < LOD_LEVELS && pixelsPerVoxel * (1 << (l + 1)) <= 1) l++;
+		if (l == level) return;
+		if (levels == null) {
+			if (c.getImage() == null) return;
+			levels = ((MCTriangulator) triangulator).getLODTriangles(c.getImage(),
+				c.getThreshold(), c.getChannels(), c.getResamplingFactor(),
+				LOD_LEVELS);
+		}
+		level = l;
+		mesh.setMesh(levels.get(level));
+	}
+
 	@Override
 		public void getMin(final Tuple3d min) {
 		min.set(this.min);
@@ -96,6 +126,8 @@ public class MeshGroup extends ContentNode {
 				+ "image. Can't change threshold");
 			return;
 		}
+		levels = null;
+		level = 0;
 		final List tri =
 			triangulator.getTriangles(c.getImage(), c.getThreshold(),
 				c.getChannels(), c.getResamplingFactor());
@@ -116,6 +148,8 @@ public class MeshGroup extends ContentNode {
 				+ "image. Can't change channels");
 			return;
 		}
+		levels = null;
+		level = 0;
 		final List tri =
 			triangulator.getTriangles(c.getImage(), c.getThreshold(),
 				c.getChannels(), c.getResamplingFactor());
@@ -44,8 +44,23 @@ public class MeshProperties {
 	public static double compute(final List p, final Point3d cm,
 		final double[][] inertia)
 	{
+		return compute(p, null, cm, inertia);
+	}
+
+	/**
+	 * Returns the mass of an indexed mesh.
+	 *
+	 * @param p List of vertices (Point3fs).
+	 * @param indices three indices into p per triangle; if null, each three
+	 *          consecutive vertices in p form a triangle.
+	 * @param cm contains the center of gravity after the calculation
+	 * @param inertia contains the inertia matrix after the calculation.
+	 */
+	public static double compute(final List p, final int[] indices,
+		final Point3d cm, final double[][] inertia)
+	{
 
-		final int tmax = p.size() / 3;
+		final int tmax = (indices == null ? p.size() : indices.length) / 3;
 		final double[] mult =
 		{ 1d / 6, 1d / 24, 1d / 24, 1d / 24, 1d / 60, 1d / 60, 1d / 60, 1d / 120,
 			1d / 120, 1d / 120 };
@@ -56,7 +71,12 @@ public class MeshProperties {
 
 		for (int t = 0; t < tmax; t++) {
 			// get vertices of triangle t
-			final int i0 = 3 * t, i1 = 3 * t + 1, i2 = 3 * t + 2;
+			int i0 = 3 * t, i1 = 3 * t + 1, i2 = 3 * t + 2;
+			if (indices != null) {
+				i0 = indices[i0];
+				i1 = indices[i1];
+				i2 = indices[i2];
+			}
 
 			final double x0 = ((Point3f)p.get(i0)).x;
 			final double y0 = ((Point3f)p.get(i0)).y;
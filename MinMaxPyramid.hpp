@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+/**
+ * Minimum and maximum intensity per brick of cubes, plus coarser levels where
+ * each brick summarizes 2x2x2 bricks of the level below. A brick whose range
+ * does not straddle the threshold contains no triangles, whatever the
+ * threshold, so the pyramid is built once per volume.
+ *
+ * Bricks are laid out on the cubes of MCCube, which run from -1 to w along x
+ * (and likewise along y and z): brick b of level 0 holds the cubes
+ * b * brickSize - 1 to (b + 1) * brickSize - 2, and its range covers all of
+ * their vertexes, with zero outside of the image.
+ */
+class MinMaxPyramid {
+public:
+	struct Level {
+		int nx, ny, nz;
+		std::vector<int> min, max;
+
+		size_t index(int bx, int by, int bz) const {
+			return ((size_t)bz * ny + by) * nx + bx;
+		}
+	};
+
+	int brickSize;
+	std::vector<Level> levels;
+
+	MinMaxPyramid() : brickSize(0) {}
+
+	/**
+	 * Builds the pyramid for a w x h x d volume; load(x, y, z) returns the
+	 * intensity of an in-bounds voxel.
+	 */
+	template <typename Load>
+	void build(int w, int h, int d, int brickSize, Load load) {
+		this->brickSize = brickSize;
+		levels.clear();
+
+		Level l0;
+		l0.nx = (w + 2 + brickSize - 1) / brickSize;
+		l0.ny = (h + 2 + brickSize - 1) / brickSize;
+		l0.nz = (d + 2 + brickSize - 1) / brickSize;
+		l0.min.assign((size_t)l0.nx * l0.ny * l0.nz, INT_MAX);
+		l0.max.assign((size_t)l0.nx * l0.ny * l0.nz, INT_MIN);
+		for (int bz = 0; bz < l0.nz; bz++) {
+			for (int by = 0; by < l0.ny; by++) {
+				for (int bx = 0; bx < l0.nx; bx++) {
+					const size_t i = l0.index(bx, by, bz);
+					int mn = INT_MAX, mx = INT_MIN;
+					// vertexes of the cubes of this brick
+					const int x0 = bx * brickSize - 1, x1 = std::min(x0 + brickSize, w + 1);
+					const int y0 = by * brickSize - 1, y1 = std::min(y0 + brickSize, h + 1);
+					const int z0 = bz * brickSize - 1, z1 = std::min(z0 + brickSize, d + 1);
+					if (x0 < 0 || y0 < 0 || z0 < 0 || x1 >= w || y1 >= h || z1 >= d)
+						mn = mx = 0;
+					for (int z = std::max(z0, 0); z <= std::min(z1, d - 1); z++) {
+						for (int y = std::max(y0, 0); y <= std::min(y1, h - 1); y++) {
+							for (int x = std::max(x0, 0); x <= std::min(x1, w - 1); x++) {
+								const int v = load(x, y, z);
+								mn = std::min(mn, v);
+								mx = std::max(mx, v);
+							}
+						}
+					}
+					l0.min[i] = mn;
+					l0.max[i] = mx;
+				}
+			}
+		}
+		levels.push_back(l0);
+
+		while (levels.back().nx > 1 || levels.back().ny > 1 || levels.back().nz > 1) {
+			const Level& fine = levels.back();
+			Level coarse;
+			coarse.nx = (fine.nx + 1) / 2;
+			coarse.ny = (fine.ny + 1) / 2;
+			coarse.nz = (fine.nz + 1) / 2;
+			coarse.min.assign((size_t)coarse.nx * coarse.ny * coarse.nz, INT_MAX);
+			coarse.max.assign((size_t)coarse.nx * coarse.ny * coarse.nz, INT_MIN);
+			for (int bz = 0; bz < fine.nz; bz++) {
+				for (int by = 0; by < fine.ny; by++) {
+					for (int bx = 0; bx < fine.nx; bx++) {
+						const size_t i = fine.index(bx, by, bz);
+						const size_t j = coarse.index(bx / 2, by / 2, bz / 2);
+						coarse.min[j] = std::min(coarse.min[j], fine.min[i]);
+						coarse.max[j] = std::max(coarse.max[j], fine.max[i]);
+					}
+				}
+			}
+			levels.push_back(coarse);
+		}
+	}
+
+	/**
+	 * Returns true if the brick may contain triangles, i.e. if some of its
+	 * vertexes are above the threshold and some are not.
+	 */
+	bool straddles(int level, int bx, int by, int bz, float threshold) const {
+		const Level& l = levels[level];
+		const size_t i = l.index(bx, by, bz);
+		return l.max[i] - threshold > 0 && !(l.min[i] - threshold > 0);
+	}
+
+	/**
+	 * Returns true if the brick straddles some threshold between lo and hi.
+	 */
+	bool intersects(int level, int bx, int by, int bz, float lo, float hi) const {
+		const Level& l = levels[level];
+		const size_t i = l.index(bx, by, bz);
+		return l.max[i] - lo > 0 && !(l.min[i] - hi > 0) && l.min[i] < l.max[i];
+	}
+
+	/**
+	 * Collects the level 0 bricks straddling some threshold between lo and
+	 * hi, descending from the coarsest level, as indices into Level::min and
+	 * Level::max, in increasing order.
+	 */
+	void bricksInRange(float lo, float hi, std::vector<size_t>& bricks) const {
+		bricks.clear();
+		collect((int)levels.size() - 1, 0, 0, 0, lo, hi, bricks);
+		std::sort(bricks.begin(), bricks.end());
+	}
+
+	/**
+	 * Marks the level 0 bricks of the layer bz which straddle some threshold
+	 * between lo and hi, descending from the coarsest level; mask is indexed
+	 * by by * nx + bx.
+	 *
+	 * @return the number of marked bricks
+	 */
+	int activeBricks(int bz, float lo, float hi, std::vector<unsigned char>& mask) const {
+		const Level& l0 = levels[0];
+		mask.assign((size_t)l0.nx * l0.ny, 0);
+		if (bz < 0 || bz >= l0.nz)
+			return 0;
+		return mark((int)levels.size() - 1, 0, 0, bz, lo, hi, mask);
+	}
+
+private:
+	void collect(int level, int bx, int by, int bz, float lo, float hi,
+		std::vector<size_t>& bricks) const
+	{
+		const Level& l = levels[level];
+		if (bx >= l.nx || by >= l.ny || bz >= l.nz || !intersects(level, bx, by, bz, lo, hi))
+			return;
+		if (level == 0) {
+			bricks.push_back(l.index(bx, by, bz));
+			return;
+		}
+		for (int z = 0; z < 2; z++)
+			for (int y = 0; y < 2; y++)
+				for (int x = 0; x < 2; x++)
+					collect(level - 1, 2 * bx + x, 2 * by + y, 2 * bz + z, lo, hi, bricks);
+	}
+
+	int mark(int level, int bx, int by, int bz, float lo, float hi,
+		std::vector<unsigned char>& mask) const
+	{
+		const Level& l = levels[level];
+		if (bx >= l.nx || by >= l.ny || !intersects(level, bx, by, bz >> level, lo, hi))
+			return 0;
+		if (level == 0) {
+			mask[(size_t)by * l.nx + bx] = 1;
+			return 1;
+		}
+		int n = 0;
+		for (int y = 0; y < 2; y++)
+			for (int x = 0; x < 2; x++)
+				n += mark(level - 1, 2 * bx + x, 2 * by + y, bz, lo, hi, mask);
+		return n;
+	}
+};
@@ -0,0 +1,120 @@
+/**
+ * Tests of MinMaxPyramid against the ranges of the bricks computed voxel by
+ * voxel: straddles(), and the bricks found by bricksInRange() and
+ * activeBricks() descending from the coarsest level.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <vector>
+
+#include "MinMaxPyramid.hpp"
+
+static const int W = 21, H = 17, D = 13, BRICK = 4;
+static std::vector<int> voxels;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+	if (!ok) {
+		std::printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+/** the intensity of the vertex (x, y, z) of a cube, zero outside */
+static int vertex(int x, int y, int z) {
+	if (x < 0 || y < 0 || z < 0 || x >= W || y >= H || z >= D) return 0;
+	return voxels[((size_t)z * H + y) * W + x];
+}
+
+/** the range of the vertexes of the cubes of brick (bx, by, bz) of level 0 */
+static void range(int bx, int by, int bz, int& mn, int& mx) {
+	mn = INT_MAX;
+	mx = INT_MIN;
+	for (int z = bz * BRICK - 1; z <= std::min(bz * BRICK - 1 + BRICK, D); z++)
+		for (int y = by * BRICK - 1; y <= std::min(by * BRICK - 1 + BRICK, H); y++)
+			for (int x = bx * BRICK - 1; x <= std::min(bx * BRICK - 1 + BRICK, W); x++) {
+				mn = std::min(mn, vertex(x, y, z));
+				mx = std::max(mx, vertex(x, y, z));
+			}
+}
+
+int main() {
+	// a ramp along x with a bright box, so that bricks range from constant
+	// to straddling everything
+	voxels.resize((size_t)W * H * D);
+	for (int z = 0; z < D; z++)
+		for (int y = 0; y < H; y++)
+			for (int x = 0; x < W; x++)
+				voxels[((size_t)z * H + y) * W + x] = 10 * (x / 3) +
+					(x > 12 && y > 9 && z > 6 ? 200 : 0);
+	MinMaxPyramid pyramid;
+	pyramid.build(W, H, D, BRICK, [](int x, int y, int z) {
+		return voxels[((size_t)z * H + y) * W + x];
+	});
+	const MinMaxPyramid::Level& l0 = pyramid.levels[0];
+	check(pyramid.levels.back().nx == 1 && pyramid.levels.back().ny == 1 &&
+		pyramid.levels.back().nz == 1, "the coarsest level is one brick");
+
+	const float thresholds[] = { -0.5f, 0.5f, 14.5f, 30.5f, 60.5f, 200.5f, 300.5f };
+	for (int bz = 0; bz < l0.nz; bz++)
+		for (int by = 0; by < l0.ny; by++)
+			for (int bx = 0; bx < l0.nx; bx++) {
+				int mn, mx;
+				range(bx, by, bz, mn, mx);
+				const size_t i = l0.index(bx, by, bz);
+				check(l0.min[i] == mn && l0.max[i] == mx, "range of a brick");
+				for (float t : thresholds)
+					check(pyramid.straddles(0, bx, by, bz, t) == (mx > t && !(mn > t)),
+						"straddles()");
+			}
+
+	// a coarse brick straddles whenever one of its bricks does
+	for (size_t k = 1; k < pyramid.levels.size(); k++) {
+		const MinMaxPyramid::Level& fine = pyramid.levels[k - 1];
+		for (int bz = 0; bz < fine.nz; bz++)
+			for (int by = 0; by < fine.ny; by++)
+				for (int bx = 0; bx < fine.nx; bx++)
+					for (float t : thresholds)
+						if (pyramid.straddles((int)k - 1, bx, by, bz, t))
+							check(pyramid.straddles((int)k, bx / 2, by / 2, bz / 2, t),
+								"coarse bricks straddle");
+	}
+
+	const float ranges[][2] = { { 0.5f, 0.5f }, { 14.5f, 30.5f }, { 100.5f, 250.5f },
+		{ 300.5f, 400.5f }, { -10.0f, 1000.0f } };
+	for (const float* r : ranges) {
+		std::vector<size_t> bricks;
+		pyramid.bricksInRange(r[0], r[1], bricks);
+		std::vector<size_t> expected;
+		for (int bz = 0; bz < l0.nz; bz++)
+			for (int by = 0; by < l0.ny; by++)
+				for (int bx = 0; bx < l0.nx; bx++) {
+					int mn, mx;
+					range(bx, by, bz, mn, mx);
+					if (mx > r[0] && !(mn > r[1]) && mn < mx)
+						expected.push_back(l0.index(bx, by, bz));
+				}
+		check(bricks == expected, "bricksInRange()");
+
+		// the same bricks, layer by layer
+		std::vector<size_t> marked;
+		for (int bz = 0; bz < l0.nz; bz++) {
+			std::vector<unsigned char> mask;
+			const int n = pyramid.activeBricks(bz, r[0], r[1], mask);
+			int count = 0;
+			for (size_t j = 0; j < mask.size(); j++)
+				if (mask[j]) {
+					marked.push_back((size_t)bz * l0.nx * l0.ny + j);
+					count++;
+				}
+			check(n == count, "activeBricks() counts the marked bricks");
+		}
+		check(marked == expected, "activeBricks()");
+	}
+
+	if (failures == 0) std::printf("MinMaxPyramidTest: passed\n");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ContiguousImage.hpp"
+
+/**
+ * The swap file of Volume: a fixed size header followed by the voxels, slice
+ * after slice, in the byte order of the machine. The voxels start on a page
+ * boundary, so that the file can be mapped into memory and used in place;
+ * pages are then read on first access rather than up front.
+ */
+namespace RawVolumeFile {
+
+	static const char MAGIC[8] = { 'V', 'T', 'P', 'R', 'A', 'W', '0', '1' };
+
+	// offset of the voxels, and size of the writes
+	static const size_t ALIGNMENT = 4096;
+	static const size_t CHUNK = 1024 * ALIGNMENT;
+
+	struct Header {
+		char magic[8];
+		// the ImagePlus type and the size of its pixels
+		int32_t type, bytesPerVoxel;
+		int32_t w, h, d;
+		int32_t reserved;
+		// the calibration: pixel size and origin
+		double pw, ph, pd;
+		double xOrigin, yOrigin, zOrigin;
+		// red, green, blue and alpha LUT
+		int32_t luts[4][256];
+		uint64_t dataOffset;
+
+		size_t sliceSize() const {
+			return (size_t)w * h * bytesPerVoxel;
+		}
+	};
+
+	/** a header for a w x h x d image of the given type, all else zero */
+	inline Header header(int type, int bytesPerVoxel, int w, int h, int d) {
+		Header header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.type = type;
+		header.bytesPerVoxel = bytesPerVoxel;
+		header.w = w;
+		header.h = h;
+		header.d = d;
+		header.dataOffset = (sizeof(Header) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		return header;
+	}
+
+	/** flushes the written data of f to disk */
+	inline bool sync(FILE* f) {
+#if defined(_WIN32)
+		return _commit(_fileno(f)) == 0;
+#else
+		return fsync(fileno(f)) == 0;
+#endif
+	}
+
+	/**
+	 * Writes the header and the header.d slices to path. The file is written
+	 * front to back in aligned chunks of CHUNK bytes, bypassing the buffering
+	 * of stdio, and synced to disk before it is closed, so that it may then
+	 * replace() an older file. Returns false on failure.
+	 */
+	inline bool write(const std::string& path, const Header& header,
+		const void* const* slices)
+	{
+		FILE* f = std::fopen(path.c_str(), "wb");
+		if (f == nullptr) return false;
+		std::setvbuf(f, nullptr, _IONBF, 0);
+		ContiguousImage<unsigned char> chunk((int)CHUNK, 1, 1);
+		unsigned char* buffer = chunk.data;
+		std::memset(buffer, 0, (size_t)header.dataOffset);
+		std::memcpy(buffer, &header, sizeof(header));
+		size_t used = (size_t)header.dataOffset;
+		bool ok = true;
+		const size_t sliceSize = header.sliceSize();
+		for (int z = 0; z < header.d && ok; z++) {
+			const unsigned char* src = (const unsigned char*)slices[z];
+			for (size_t done = 0; done < sliceSize && ok; ) {
+				const size_t n = std::min(sliceSize - done, CHUNK - used);
+				std::memcpy(buffer + used, src + done, n);
+				used += n;
+				done += n;
+				if (used == CHUNK) {
+					ok = std::fwrite(buffer, 1, used, f) == used;
+					used = 0;
+				}
+			}
+		}
+		if (ok && used > 0)
+			ok = std::fwrite(buffer, 1, used, f) == used;
+		if (ok)
+			ok = std::fflush(f) == 0 && sync(f);
+		return std::fclose(f) == 0 && ok;
+	}
+
+	/**
+	 * Replaces the file to with the file from, e.g. a swap file with the one
+	 * just written next to it. On POSIX systems, a mapping of the old file
+	 * stays valid; on Windows, the old file must not be mapped any more.
+	 */
+	inline bool replace(const std::string& from, const std::string& to) {
+#if defined(_WIN32)
+		return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+	}
+
+	/**
+	 * A swap file mapped copy-on-write: the voxels may be changed in memory,
+	 * but the changes are never written back. The mapping is released with
+	 * the last reference to it.
+	 */
+	class Mapping {
+	public:
+		/** maps path, or returns null if it is not a valid swap file */
+		static std::shared_ptr<Mapping> open(const std::string& path) {
+			std::shared_ptr<Mapping> m(new Mapping());
+#if defined(_WIN32)
+			HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+				nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE) return nullptr;
+			LARGE_INTEGER size;
+			HANDLE map = nullptr;
+			if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+				map = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+			CloseHandle(file);
+			if (map == nullptr) return nullptr;
+			m->base = (unsigned char*)MapViewOfFile(map, FILE_MAP_COPY, 0, 0, 0);
+			CloseHandle(map);
+			if (m->base == nullptr) return nullptr;
+			m->size = (size_t)size.QuadPart;
+#else
+			const int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0) return nullptr;
+			struct stat st;
+			void* p = MAP_FAILED;
+			if (fstat(fd, &st) == 0 && st.st_size > 0)
+				p = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE,
+					MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if (p == MAP_FAILED) return nullptr;
+			m->base = (unsigned char*)p;
+			m->size = (size_t)st.st_size;
+#endif
+			if (!m->valid()) return nullptr;
+			return m;
+		}
+
+		~Mapping() {
+			if (base == nullptr) return;
+#if defined(_WIN32)
+			UnmapViewOfFile(base);
+#else
+			munmap(base, size);
+#endif
+		}
+
+		const Header& header() const {
+			return *(const Header*)base;
+		}
+
+		/** the slice z, header().sliceSize() bytes */
+		void* slice(int z) const {
+			return base + header().dataOffset + z * header().sliceSize();
+		}
+
+	private:
+		unsigned char* base;
+		size_t size;
+
+		Mapping() : base(nullptr), size(0) {}
+		Mapping(const Mapping&) = delete;
+		Mapping& operator=(const Mapping&) = delete;
+
+		bool valid() const {
+			if (size < sizeof(Header)) return false;
+			const Header& h = header();
+			return std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+				h.w >= 0 && h.h >= 0 && h.d >= 0 && h.bytesPerVoxel > 0 &&
+				h.dataOffset >= sizeof(Header) && h.dataOffset <= size &&
+				(h.sliceSize() == 0 ||
+					(size - h.dataOffset) / h.sliceSize() >= (size_t)h.d);
+		}
+	};
+}
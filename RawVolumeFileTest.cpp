@@ -0,0 +1,137 @@
+/**
+ * Tests of RawVolumeFile: volumes written with write() and mapped with
+ * Mapping::open() come back with the same header and voxels, also across
+ * the chunks of the writer; replace() keeps the mappings of the old file
+ * valid, changes in a mapping never reach the file, and files which are
+ * not complete swap files are refused. The files are created in the
+ * working directory and removed again.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "RawVolumeFile.hpp"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+	if (!ok) {
+		std::printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+/** d slices of w x h voxels of type T, each voxel depending on its position */
+template <typename T>
+static std::vector<std::vector<T>> volume(int w, int h, int d, int seed) {
+	std::vector<std::vector<T>> slices(d, std::vector<T>((size_t)w * h));
+	for (int z = 0; z < d; z++)
+		for (size_t i = 0; i < slices[z].size(); i++)
+			slices[z][i] = (T)(i * 7 + z * 13 + seed);
+	return slices;
+}
+
+template <typename T>
+static bool write(const std::string& path, RawVolumeFile::Header& header,
+	const std::vector<std::vector<T>>& slices)
+{
+	std::vector<const void*> p(slices.size());
+	for (size_t z = 0; z < slices.size(); z++)
+		p[z] = slices[z].data();
+	return RawVolumeFile::write(path, header, p.data());
+}
+
+template <typename T>
+static bool sameVoxels(const RawVolumeFile::Mapping& m,
+	const std::vector<std::vector<T>>& slices)
+{
+	bool same = m.header().d == (int)slices.size();
+	for (size_t z = 0; z < slices.size() && same; z++)
+		same = std::memcmp(m.slice((int)z), slices[z].data(),
+			slices[z].size() * sizeof(T)) == 0;
+	return same;
+}
+
+/** a volume of the given type round trips, with its calibration and LUTs */
+template <typename T>
+static void testRoundTrip(const std::string& path, int type, int w, int h, int d) {
+	const std::vector<std::vector<T>> slices = volume<T>(w, h, d, type);
+	RawVolumeFile::Header header = RawVolumeFile::header(type, sizeof(T), w, h, d);
+	header.pw = 0.5;
+	header.pd = 2.25;
+	header.zOrigin = -3;
+	for (int c = 0; c < 4; c++)
+		for (int i = 0; i < 256; i++)
+			header.luts[c][i] = (255 - i) * (c + 1) / 4;
+	check(write(path, header, slices), "write()");
+
+	const std::shared_ptr<RawVolumeFile::Mapping> m = RawVolumeFile::Mapping::open(path);
+	check(m != nullptr, "open() maps the written file");
+	if (m == nullptr) return;
+	check(std::memcmp(&m->header(), &header, sizeof(header)) == 0,
+		"the header round trips");
+	check(m->header().dataOffset % RawVolumeFile::ALIGNMENT == 0,
+		"the voxels start on a page boundary");
+	check(sameVoxels(*m, slices), "the voxels round trip");
+}
+
+int main() {
+	const std::string path = "RawVolumeFileTest.raw";
+	const std::string next = "RawVolumeFileTest.raw.new";
+
+	// bytes in a single chunk; shorts and floats whose slices straddle the
+	// chunks of the writer
+	testRoundTrip<unsigned char>(path, 0, 37, 29, 11);
+	testRoundTrip<short>(path, 1, 1500, 1000, 3);
+	testRoundTrip<float>(path, 2, 777, 555, 5);
+
+	// replace() while the old file is mapped, which then stays valid; on
+	// Windows, a mapped file cannot be replaced
+	const std::vector<std::vector<short>> before = volume<short>(64, 48, 4, 1);
+	const std::vector<std::vector<short>> after = volume<short>(64, 48, 4, 2);
+	RawVolumeFile::Header header = RawVolumeFile::header(1, 2, 64, 48, 4);
+	check(write(path, header, before), "write() the old file");
+	{
+		std::shared_ptr<RawVolumeFile::Mapping> old = RawVolumeFile::Mapping::open(path);
+		check(old != nullptr && write(next, header, after), "write() the new file");
+#if !defined(_WIN32)
+		check(RawVolumeFile::replace(next, path), "replace()");
+		check(old != nullptr && sameVoxels(*old, before),
+			"a mapping of the replaced file is unchanged");
+#endif
+	}
+#if defined(_WIN32)
+	check(RawVolumeFile::replace(next, path), "replace()");
+#endif
+	std::shared_ptr<RawVolumeFile::Mapping> m = RawVolumeFile::Mapping::open(path);
+	check(m != nullptr && sameVoxels(*m, after), "open() maps the new file");
+
+	// changes in a mapping stay in memory
+	if (m != nullptr) {
+		((short*)m->slice(2))[5] = -1;
+		m = RawVolumeFile::Mapping::open(path);
+		check(m != nullptr && sameVoxels(*m, after), "the file is copy-on-write");
+	}
+	m = nullptr;
+
+	// files which are not complete swap files
+	check(RawVolumeFile::Mapping::open("RawVolumeFileTest.missing") == nullptr,
+		"a missing file is refused");
+	FILE* f = std::fopen(next.c_str(), "wb");
+	const std::vector<unsigned char> garbage(8192, 'x');
+	std::fwrite(garbage.data(), 1, garbage.size(), f);
+	std::fclose(f);
+	check(RawVolumeFile::Mapping::open(next) == nullptr, "a foreign file is refused");
+	f = std::fopen(next.c_str(), "wb");
+	std::fwrite(&header, 1, sizeof(header), f);
+	std::fclose(f);
+	check(RawVolumeFile::Mapping::open(next) == nullptr,
+		"a file without all of its slices is refused");
+
+	std::remove(path.c_str());
+	std::remove(next.c_str());
+	if (failures == 0) std::printf("RawVolumeFileTest: passed\n");
+	return failures == 0 ? 0 : 1;
+}
@@ -26,15 +26,26 @@
  * images, and to specify whether or not to average several channels (and merge
  * them in this way into one byte per pixel). Depending on these settings, and
  * on the type of image given at construction time, the returned data type is
- * one of INT_DATA or BYTE_DATA.
+ * one of INT_DATA or BYTE_DATA. 16 and 32 bit gray images are always read as
+ * INT_DATA; see also withNativeLoader().
  *
  * @author Benjamin Schmid
  */
 
+#include <algorithm>
 #include <math.h>
+#include <memory>
+#include <vector>
 
+#include "BoxResampler.hpp"
+#include "BrickedImage.hpp"
+#include "CompressedBrickImage.hpp"
+#include "ContiguousImage.hpp"
 #include "ImagePlus.hpp"
 #include "Loader.hpp"
+#include "MinMaxPyramid.hpp"
+#include "RawVolumeFile.hpp"
+#include "VoxelLoaders.hpp"
 
 #include "thirdparties/include/glm/glm.hpp"
 
@@ -90,6 +101,21 @@ protected:
 	/** Channels in RGB images which should be loaded */
 	bool channels[3] = { true, true, true };
 
+	/**
+	 * Flag indicating that the slices are copied into one contiguous buffer
+	 * if they are not contiguous in the ImageStack already
+	 */
+	bool contiguous = false;
+
+	/**
+	 * Edge length of the bricks the voxels are copied into, see
+	 * setBrickedLayout(); 0 if they are kept in rows
+	 */
+	int brickedLayout = 0;
+
+	/** Flag indicating that the voxels are kept compressed in bricks */
+	bool compressed = false;
+
 	/** The dimensions of the data */
 public:
 	int xDim, yDim, zDim;
@@ -103,6 +129,29 @@ public:
 	/** The maximum coordinate of the data */
 	vec3 maxCoord = vec3();
 
+protected:
+	/** Edge length of the bricks of the min/max pyramid, in cubes */
+	int brickSize = 8;
+
+	/** The min/max pyramid of the loaded data; null until it is needed */
+	std::shared_ptr<MinMaxPyramid> pyramid;
+
+	/** Flag indicating that BYTE_DATA is baked into 8 bit volumes */
+	bool byteCache = false;
+
+	/**
+	 * load() and loadWithLUT() of every voxel, for BYTE_DATA with byteCache
+	 * set; empty until needed, and whenever the data, the channels, the
+	 * averaging or the LUTs change
+	 */
+	ContiguousImage<unsigned char> bytes, lutBytes;
+
+	/** The swap file the pixels of a restored image live in, if any */
+	std::shared_ptr<RawVolumeFile::Mapping> mapping;
+
+	/** The pixels of a resampled image, see setImage(imp, ch, f) */
+	std::shared_ptr<void> resampled;
+
 	/** Create instance with a null imp. */
 protected:
 	Volume() {
@@ -131,10 +180,20 @@ public:
 		setImage(imp, ch);
 	}
 
+	/**
+	 * Initializes this Volume with the specified image downsampled by
+	 * resamplingF, see setImage(imp, ch, f).
+	 */
+	Volume(ImagePlus imp, bool* ch, int resamplingF) {
+		setImage(imp, ch, resamplingF);
+	}
+
 private:
 	void setLUTsFromImage(ImagePlus imp) {
 		switch (imp.getType()) {
 			case ImagePlus.GRAY8:
+			case ImagePlus.GRAY16:
+			case ImagePlus.GRAY32:
 			case ImagePlus.COLOR_256:
 				IndexColorModel cm = (IndexColorModel)imp.getProcessor().getCurrentColorModel();
 				for (int i = 0; i < 256; i++) {
@@ -158,20 +217,12 @@ private:
 public:
 	void setImage(ImagePlus imp, bool ch[3]) {
 		this->imp = imp;
+		mapping = NULL;
+		resampled = NULL;
 		this->channels[0] = ch[0];
 		this->channels[1] = ch[1];
 		this->channels[2] = ch[2];
-		switch (imp.getType()) {
-			case ImagePlus.GRAY8:
-			case ImagePlus.COLOR_256:
-				image = new ByteImage(imp);
-				break;
-			case ImagePlus.COLOR_RGB:
-				image = new IntImage(imp);
-				break;
-			default:
-				return;
-		}
+		if (!initImage()) return;
 		setLUTsFromImage(this->imp);
 
 		xDim = imp.getWidth();
@@ -199,25 +250,323 @@ public:
 		initLoader();
 	}
 
+	/**
+	 * Like setImage(imp, ch), but with the image downsampled by f in each
+	 * direction: each voxel is the mean of the f x f x f voxels it covers,
+	 * per channel for RGB images, as with NaiveResampler.resample(imp, f).
+	 * The stack is downsampled directly from its pixels, in parallel (see
+	 * BoxResampler), into one contiguous buffer, which the new image wraps.
+	 */
+	void setImage(ImagePlus imp, bool ch[3], int f) {
+		if (f <= 1) {
+			setImage(imp, ch);
+			return;
+		}
+		ImageStack stack;
+		std::shared_ptr<void> pixels;
+		switch (imp.getType()) {
+			case ImagePlus.GRAY8:
+			case ImagePlus.COLOR_256:
+				pixels = resample<byte>(imp, f, stack);
+				break;
+			case ImagePlus.GRAY16:
+				pixels = resample<short>(imp, f, stack);
+				break;
+			case ImagePlus.GRAY32:
+				pixels = resample<float>(imp, f, stack);
+				break;
+			case ImagePlus.COLOR_RGB:
+				pixels = resample<int>(imp, f, stack);
+				break;
+			default:
+				return;
+		}
+		stack.setColorModel(imp.getStack().getColorModel());
+		final ImagePlus small = new ImagePlus(imp.getTitle(), stack);
+		final Calibration cal = imp.getCalibration().copy();
+		cal.pixelWidth *= f;
+		cal.pixelHeight *= f;
+		cal.pixelDepth *= f;
+		small.setCalibration(cal);
+
+		setImage(small, ch);
+		resampled = pixels;
+	}
+
+private:
+	/** the stack of imp downsampled by f into out, and its pixels */
+	template <typename T>
+	static std::shared_ptr<void> resample(ImagePlus imp, int f, ImageStack& out) {
+		final ImageStack stack = imp.getStack();
+		final int d = imp.getStackSize();
+		std::vector<const T*> slices(d);
+		for (int z = 0; z < d; z++)
+			slices[z] = (const T*)stack.getPixels(z + 1);
+		final std::shared_ptr<ContiguousImage<T>> pixels =
+			std::make_shared<ContiguousImage<T>>(BoxResampler::resample(
+				slices.data(), imp.getWidth(), imp.getHeight(), d, f, 0));
+		out = new ImageStack(pixels->w, pixels->h);
+		for (int z = 0; z < pixels->d; z++)
+			out.addSlice("", pixels->slice(z));
+		return pixels;
+	}
+
+public:
 	ImagePlus getImagePlus() {
 		return imp;
 	}
 
+	/**
+	 * If true, copy the slices of the image into a single, 64 byte aligned
+	 * buffer with constant strides, unless they are contiguous in memory
+	 * already, in which case they are used in place. If false, contiguous
+	 * slices are still used in place, but nothing is copied.
+	 *
+	 * @return true if the value for 'contiguous' has changed.
+	 */
+	bool setContiguous(const bool c) {
+		if (contiguous == c) return false;
+		contiguous = c;
+		if (imp != NULL && initImage()) initLoader();
+		return true;
+	}
+
+	bool isContiguous() {
+		return contiguous;
+	}
+
+	/**
+	 * If edge > 0, copy the voxels into bricks of edge^3 voxels, with the
+	 * voxels of each brick in Morton order (see BrickedImage), and read them
+	 * from there; edge is rounded up to a power of two. This keeps 3D
+	 * neighbourhoods close in memory. The contiguous copy of setContiguous()
+	 * is then not made. If edge is 0, the voxels are kept in rows.
+	 *
+	 * @return true if the value for 'brickedLayout' has changed.
+	 */
+	bool setBrickedLayout(const int edge) {
+		if (brickedLayout == edge) return false;
+		brickedLayout = edge;
+		if (imp != NULL && initImage()) initLoader();
+		return true;
+	}
+
+	int getBrickedLayout() {
+		return brickedLayout;
+	}
+
+	/**
+	 * If true, keep a compressed copy of the voxels (see CompressedBrickImage)
+	 * and read them from there, rather than making the contiguous or bricked
+	 * copies of setContiguous() and setBrickedLayout(). Meant for mostly empty
+	 * volumes such as labels and masks, which typically shrink by far more
+	 * than 10x; every thread decompresses the slices of bricks it reads into
+	 * a small cache of its own. The compressed voxels replace the slices of
+	 * the image: the volume reads and writes only them, and set() no longer
+	 * changes the ImageStack.
+	 *
+	 * @return true if the value for 'compressed' has changed.
+	 */
+	bool setCompressed(const bool c) {
+		if (compressed == c) return false;
+		compressed = c;
+		if (imp != NULL && initImage()) initLoader();
+		return true;
+	}
+
+	bool isCompressed() {
+		return compressed;
+	}
+
 	void clear() {
 		imp = NULL;
 		image = NULL;
 		loader = NULL;
+		pyramid = NULL;
+		clearByteCache();
+		mapping = NULL;
+		resampled = NULL;
 	}
 
+	/**
+	 * Writes the image, its calibration and the LUTs to path + ".raw" (see
+	 * RawVolumeFile) and releases it. If the file cannot be written, the
+	 * image is kept.
+	 */
 	void swap(std::string path) {
-		IJ.save(imp, path + ".tif");
-		imp = NULL;
-		image = NULL;
-		loader = NULL;
+		int bytesPerVoxel;
+		switch (imp.getType()) {
+			case ImagePlus.GRAY8:
+			case ImagePlus.COLOR_256:
+				bytesPerVoxel = 1;
+				break;
+			case ImagePlus.GRAY16:
+				bytesPerVoxel = 2;
+				break;
+			case ImagePlus.GRAY32:
+			case ImagePlus.COLOR_RGB:
+				bytesPerVoxel = 4;
+				break;
+			default:
+				return;
+		}
+		RawVolumeFile::Header header = RawVolumeFile::header(imp.getType(),
+			bytesPerVoxel, xDim, yDim, zDim);
+		header.pw = pw;
+		header.ph = ph;
+		header.pd = pd;
+		header.xOrigin = minCoord.x;
+		header.yOrigin = minCoord.y;
+		header.zOrigin = minCoord.z;
+		for (int i = 0; i < 256; i++) {
+			header.luts[0][i] = rLUT[i];
+			header.luts[1][i] = gLUT[i];
+			header.luts[2][i] = bLUT[i];
+			header.luts[3][i] = aLUT[i];
+		}
+		final ImageStack stack = imp.getStack();
+		std::vector<const void*> slices(zDim);
+		for (int z = 0; z < zDim; z++)
+			slices[z] = stack.getPixels(z + 1);
+
+		// path + ".raw" may be the file the image is mapped from
+		final std::string file = path + ".raw";
+		if (!RawVolumeFile::write(file + ".tmp", header, slices.data())) {
+			printf("Could not write %s.tmp", file.c_str());
+			return;
+		}
+		clear();
+		if (!RawVolumeFile::replace(file + ".tmp", file))
+			printf("Could not replace %s", file.c_str());
+	}
+
+	/**
+	 * Returns the min/max pyramid of the loaded data, building it if
+	 * necessary. It does not depend on the threshold, so it is kept until the
+	 * data or the way it is loaded changes.
+	 */
+	std::shared_ptr<MinMaxPyramid> getMinMaxPyramid() {
+		if (pyramid == NULL) {
+			pyramid = std::make_shared<MinMaxPyramid>();
+			pyramid->build(xDim, yDim, zDim, brickSize,
+				[this](int x, int y, int z) { return load(x, y, z); });
+		}
+		return pyramid;
+	}
+
+	/**
+	 * Set the edge length of the bricks of the min/max pyramid, in cubes.
+	 */
+	void setBrickSize(const int size) {
+		if (size != brickSize) {
+			brickSize = size;
+			pyramid = NULL;
+		}
+	}
+
+	int getBrickSize() {
+		return brickSize;
+	}
+
+	/**
+	 * If true, BYTE_DATA is baked into 8 bit volumes the first time it is
+	 * needed: the values of load(), i.e. the averaged channels, and the ones
+	 * of loadWithLUT(), with the channel selection, averaging and LUTs
+	 * applied. Both are built in parallel, and are rebuilt after any change
+	 * of the channels, the averaging, the LUTs or the data.
+	 *
+	 * @return true if the value for 'byteCache' has changed.
+	 */
+	bool setByteCache(const bool b) {
+		if (byteCache == b) return false;
+		byteCache = b;
+		clearByteCache();
+		return true;
+	}
+
+	bool isByteCache() {
+		return byteCache;
+	}
+
+	/**
+	 * Returns load() of every voxel as an 8 bit volume, building it if
+	 * necessary, or an empty image if byteCache is not set or the data type
+	 * is not BYTE_DATA.
+	 */
+	const ContiguousImage<unsigned char>& getByteVolume() {
+		if (bytes.empty() && byteCache && dataType == BYTE_DATA && image != NULL) {
+			withSourceLoader([this](const auto& loader) {
+				bytes = VoxelLoaders::bake(loader, xDim, yDim, zDim, 0);
+			});
+		}
+		return bytes;
+	}
+
+	/**
+	 * Returns loadWithLUT() of every voxel as an 8 bit volume, building it if
+	 * necessary, or an empty image if byteCache is not set or the data type
+	 * is not BYTE_DATA.
+	 */
+	const ContiguousImage<unsigned char>& getLUTByteVolume() {
+		if (lutBytes.empty() && byteCache && dataType == BYTE_DATA && image != NULL) {
+			withLUTLoader([this](const auto& loader) {
+				lutBytes = VoxelLoaders::bake(loader, xDim, yDim, zDim, 0);
+			});
+		}
+		return lutBytes;
+	}
+
+protected:
+	void clearByteCache() {
+		bytes = ContiguousImage<unsigned char>();
+		lutBytes = ContiguousImage<unsigned char>();
 	}
 
+public:
+
+	/**
+	 * Restores the image written by swap(path). The file is mapped rather
+	 * than read, so this returns at once and the pixels are paged in when
+	 * they are first accessed; changes to them stay in memory.
+	 */
 	void restore(std::string path) {
-		setImage(IJ.openImage(path + ".tif"), channels);
+		final std::shared_ptr<RawVolumeFile::Mapping> m =
+			RawVolumeFile::Mapping::open(path + ".raw");
+		if (m == NULL) {
+			printf("Could not restore %s.raw", path.c_str());
+			return;
+		}
+		final RawVolumeFile::Header& header = m->header();
+		final ImageStack stack = new ImageStack(header.w, header.h);
+		for (int z = 0; z < header.d; z++) {
+			switch (header.type) {
+				case ImagePlus.GRAY16:
+					stack.addSlice("", (short[]) m->slice(z));
+					break;
+				case ImagePlus.GRAY32:
+					stack.addSlice("", (float[]) m->slice(z));
+					break;
+				case ImagePlus.COLOR_RGB:
+					stack.addSlice("", (int[]) m->slice(z));
+					break;
+				default:
+					stack.addSlice("", (byte[]) m->slice(z));
+			}
+		}
+		final ImagePlus restored = new ImagePlus(path, stack);
+		final Calibration cal = restored.getCalibration();
+		cal.pixelWidth = header.pw;
+		cal.pixelHeight = header.ph;
+		cal.pixelDepth = header.pd;
+		cal.xOrigin = header.xOrigin;
+		cal.yOrigin = header.yOrigin;
+		cal.zOrigin = header.zOrigin;
+		restored.setCalibration(cal);
+
+		setImage(restored, channels);
+		mapping = m;
+		// the LUTs of swap(), rather than the ones of the color model
+		setLUTs(header.luts[0], header.luts[1], header.luts[2], header.luts[3]);
 	}
 
 	/**
@@ -249,6 +598,7 @@ public:
 	bool setAverage(const bool a) {
 		if (average != a) {
 			this->average = a;
+			clearByteCache();
 			initDataType();
 			initLoader();
 			return true;
@@ -326,6 +676,7 @@ public:
 	bool setChannels(const bool* ch) {
 		if (ch[0] == channels[0] && ch[1] == channels[1] && ch[2] == channels[2]) return false;
 		*channels = ch;
+		clearByteCache();
 		if (initDataType()) initLoader();
 		return true;
 	}
@@ -337,10 +688,11 @@ public:
 	bool setLUTs(const int* r, const int* g, const int* b,
 		const int* a)
 	{
-		*this->rLUT = *r;
-		*this->gLUT = *g;
-		*this->bLUT = *b;
-		*this->aLUT = *a;
+		std::copy_n(r, 256, rLUT);
+		std::copy_n(g, 256, gLUT);
+		std::copy_n(b, 256, bLUT);
+		std::copy_n(a, 256, aLUT);
+		clearByteCache();
 		if (initDataType()) {
 			initLoader();
 			return true;
@@ -356,6 +708,7 @@ public:
 		for (int i = 0; i < sizeof(this->aLUT); i++) {
 			aLUT[i] = 254;
 		}
+		clearByteCache();
 		if (initDataType()) {
 			initLoader();
 			return true;
@@ -363,12 +716,43 @@ public:
 		return false;
 	}
 
+	/**
+	 * Wraps imp into image, depending on its type. Returns false for
+	 * unsupported types.
+	 */
+protected:
+	bool initImage() {
+		// the compressed voxels or the bricks replace the contiguous copy
+		final bool copy = contiguous && brickedLayout == 0 && !compressed;
+		final int bricks = compressed ? 0 : brickedLayout;
+		switch (imp.getType()) {
+			case ImagePlus.GRAY8:
+			case ImagePlus.COLOR_256:
+				image = new ByteImage(imp, copy, bricks, compressed);
+				return true;
+			case ImagePlus.COLOR_RGB:
+				image = new IntImage(imp, copy, bricks, compressed);
+				return true;
+			case ImagePlus.GRAY16:
+				image = new ShortImage(imp, copy, bricks, compressed);
+				return true;
+			case ImagePlus.GRAY32:
+				image = new FloatImage(imp, copy, bricks, compressed);
+				return true;
+			default:
+				return false;
+		}
+	}
+
 	/**
 	 * Init the loader, based on the currently set data type, which is either
 	 * INT_DATA or BYTE_DATA.
 	 */
 protected:
 	void initLoader() {
+		// the loaded values may change
+		pyramid = NULL;
+		clearByteCache();
 		if (image == NULL) {
 			printf("No image. Maybe it is swapped?");
 			return;
@@ -397,13 +781,20 @@ protected:
 	/**
 	 * Init the data type. For 8 bit images, BYTE_DATA is used if isDefaultLUT()
 	 * returns true. For RGB images, an additional condition is that only a single
-	 * channel is used. For other cases, the data type is INT_DATA.
+	 * channel is used. 16 and 32 bit images are INT_DATA, even if averaged, so
+	 * that load() does not reduce them to 8 bit. For other cases, the data type
+	 * is INT_DATA.
 	 */
 	bool initDataType() {
 		if (image == NULL) {
 			printf("No image. Maybe it is swapped?");
 			return;
 		}
+		const int tmp = dataType;
+		if (image instanceof ShortImage || image instanceof FloatImage) {
+			dataType = INT_DATA;
+			return tmp != dataType;
+		}
 		int noChannels = 0;
 		if (image instanceof ByteImage) {
 			noChannels = 1;
@@ -413,7 +804,6 @@ protected:
 				if (channels[i]) noChannels++;
 		}
 		const bool defaultLUT = isDefaultLUT();
-		const int tmp = dataType;
 		if (average || (defaultLUT && noChannels < 2)) dataType = BYTE_DATA;
 		else dataType = INT_DATA;
 
@@ -421,6 +811,8 @@ protected:
 	}
 
 	void setNoCheck(const int x, const int y, const int z, const int v) {
+		pyramid = NULL;
+		clearByteCache();
 		try {
 			loader.setNoCheck(x, y, z, v);
 		}
@@ -431,6 +823,8 @@ protected:
 	}
 
 	void set(const int x, const int y, const int z, const int v) {
+		pyramid = NULL;
+		clearByteCache();
 		try {
 			loader.set(x, y, z, v);
 		}
@@ -449,6 +843,7 @@ protected:
 	 * @return value. Casted to int if it was a byte value before.
 	 */
 	int load(const int x, const int y, const int z) {
+		if (!bytes.empty()) return bytes.get(x, y, z);
 		try {
 			return loader.load(x, y, z);
 		}
@@ -458,6 +853,176 @@ protected:
 		}
 	}
 
+public:
+	/**
+	 * Calls f(loader) with a loader whose load(x, y, z) returns the same as
+	 * load(x, y, z), but whose type reflects the image type and the loader
+	 * in use (see VoxelLoaders). f is instantiated once per loader type, so
+	 * the loader is dispatched once per call rather than once per voxel, and
+	 * its load() can be inlined into the loops of f. Without contiguous
+	 * voxels (see setContiguous()), f gets a loader calling load(). With
+	 * byteCache set, f reads the baked 8 bit volume.
+	 *
+	 * Consumers are written as generic lambdas, e.g.
+	 * volume.withLoader([&](const auto& loader) { ... loader.load(x, y, z) ... });
+	 */
+	template <typename F>
+	void withLoader(F f) {
+		if (!getByteVolume().empty()) {
+			f(VoxelLoaders::Plain<unsigned char>(bytes));
+			return;
+		}
+		withSourceLoader(f);
+	}
+
+	/** withLoader(), always reading the image; compressed, bricks, rows */
+	template <typename F>
+	void withSourceLoader(F f) {
+		if (image instanceof ByteImage) {
+			// the average of the channels of a gray value is the value
+			if (withPlainLoader<byte>(((ByteImage)image).getPacked(),
+				((ByteImage)image).getBricks(),
+				((ByteImage)image).getVoxels(), f)) return;
+		}
+		else if (image instanceof IntImage) {
+			const ContiguousImage<int>& voxels = ((IntImage)image).getVoxels();
+			if (dataType == BYTE_DATA && average) {
+				if (!voxels.empty()) {
+					f(VoxelLoaders::AverageRGB(voxels));
+					return;
+				}
+			}
+			else if (withPlainLoader<int>(((IntImage)image).getPacked(),
+				((IntImage)image).getBricks(), voxels, f)) return;
+		}
+		else if (image instanceof ShortImage) {
+			if (withPlainLoader<short>(((ShortImage)image).getPacked(),
+				((ShortImage)image).getBricks(),
+				((ShortImage)image).getVoxels(), f)) return;
+		}
+		else if (image instanceof FloatImage) {
+			if (withPlainLoader<float>(((FloatImage)image).getPacked(),
+				((FloatImage)image).getBricks(),
+				((FloatImage)image).getVoxels(), f)) return;
+		}
+		f(VolumeLoader(this));
+	}
+
+	/**
+	 * Calls f with a Plain loader over the first non-empty one of packed,
+	 * bricks and voxels. Returns false if all are empty.
+	 */
+	template <typename T, typename F>
+	static bool withPlainLoader(const CompressedBrickImage<T>& packed,
+		const BrickedImage<T>& bricks, const ContiguousImage<T>& voxels, F& f)
+	{
+		if (!packed.empty()) {
+			f(VoxelLoaders::Plain<T, CompressedBrickImage<T>>(packed));
+			return true;
+		}
+		if (!bricks.empty()) {
+			f(VoxelLoaders::Plain<T, BrickedImage<T>>(bricks));
+			return true;
+		}
+		if (!voxels.empty()) {
+			f(VoxelLoaders::Plain<T>(voxels));
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Like withLoader(), but the loader of a 32 bit image returns its values
+	 * as float rather than truncated to int, for the loops templated on the
+	 * intensity type (see MCCube.getNativeTriangles()). For all other images,
+	 * this is withLoader(); 16 bit values are returned in full by both.
+	 */
+	template <typename F>
+	void withNativeLoader(F f) {
+		if (!(image instanceof FloatImage)) {
+			withLoader(f);
+			return;
+		}
+		const CompressedBrickImage<float>& packed = ((FloatImage)image).getPacked();
+		const BrickedImage<float>& bricks = ((FloatImage)image).getBricks();
+		const ContiguousImage<float>& voxels = ((FloatImage)image).getVoxels();
+		if (!packed.empty())
+			f(VoxelLoaders::Native<float, CompressedBrickImage<float>>(packed));
+		else if (!bricks.empty())
+			f(VoxelLoaders::Native<float, BrickedImage<float>>(bricks));
+		else if (!voxels.empty())
+			f(VoxelLoaders::Native<float>(voxels));
+		else
+			f(VolumeFloatLoader(this));
+	}
+
+	/**
+	 * Calls f(loader) with a loader whose load(x, y, z) returns the same as
+	 * loadWithLUT(x, y, z), for BYTE_DATA; see withLoader().
+	 */
+	template <typename F>
+	void withLUTLoader(F f) {
+		// ByteLoader is only used with a default LUT and a single channel
+		bool selected[3] = { channels[0], channels[1], channels[2] };
+		if (!average) {
+			int channel = 0;
+			if (image instanceof IntImage) {
+				for (int i = 0; i < 3; i++)
+					if (channels[i]) channel = i;
+			}
+			for (int i = 0; i < 3; i++)
+				selected[i] = i == channel;
+		}
+		if (image instanceof ByteImage) {
+			const ContiguousImage<byte>& voxels = ((ByteImage)image).getVoxels();
+			if (!voxels.empty()) {
+				f(VoxelLoaders::AverageLUT<byte>(voxels, rLUT, gLUT, bLUT, selected));
+				return;
+			}
+		}
+		else if (image instanceof IntImage) {
+			const ContiguousImage<int>& voxels = ((IntImage)image).getVoxels();
+			if (!voxels.empty()) {
+				f(VoxelLoaders::AverageLUT<int>(voxels, rLUT, gLUT, bLUT, selected));
+				return;
+			}
+		}
+		f(VolumeLUTLoader(this));
+	}
+
+	/** The loader of withLoader() for data which is not contiguous. */
+	struct VolumeLoader {
+		Volume* volume;
+
+		explicit VolumeLoader(Volume* volume) : volume(volume) {}
+
+		int load(int x, int y, int z) const {
+			return volume->load(x, y, z);
+		}
+	};
+
+	/** The loader of withNativeLoader() for data which is not contiguous. */
+	struct VolumeFloatLoader {
+		Volume* volume;
+
+		explicit VolumeFloatLoader(Volume* volume) : volume(volume) {}
+
+		float load(int x, int y, int z) const {
+			return volume->image.getFloat(x, y, z);
+		}
+	};
+
+	/** The loader of withLUTLoader() for data which is not contiguous. */
+	struct VolumeLUTLoader {
+		Volume* volume;
+
+		explicit VolumeLUTLoader(Volume* volume) : volume(volume) {}
+
+		int load(int x, int y, int z) const {
+			return volume->loader.loadWithLUT(x, y, z);
+		}
+	};
+
 	/**
 	 * Load the color at the specified position
 	 *
@@ -467,6 +1032,7 @@ protected:
 	 * @return int-packed color
 	 */
 	int loadWithLUT(const int x, const int y, const int z) {
+		if (!lutBytes.empty()) return lutBytes.get(x, y, z);
 		try {
 			return loader.loadWithLUT(x, y, z);
 		}
@@ -515,6 +1081,10 @@ protected:
 
 		public int get(int x, int y, int z);
 
+		/** get(x, y, z), without truncating float values */
+		public float getFloat(int x, int y, int z);
+
+		/** the color in 8 bit channels */
 		public void get(int x, int y, int z, int[] c);
 
 		public byte getAverage(int x, int y, int z);
@@ -527,25 +1097,74 @@ protected:
 		protected byte[][] fData;
 		private final int w;
 
-		protected ByteImage(final ImagePlus imp) {
+		/** the slices in one buffer, or empty; see setContiguous() */
+		protected ContiguousImage<byte> voxels;
+
+		/** the voxels in bricks, or empty; see setBrickedLayout() */
+		protected BrickedImage<byte> bricks;
+
+		/** the voxels compressed, or empty; see setCompressed() */
+		protected CompressedBrickImage<byte> packed;
+
+		protected ByteImage(final ImagePlus imp, final bool copy,
+			final int brickEdge, final bool compress)
+		{
 			final ImageStack stack = imp.getStack();
 			w = imp.getWidth();
 			final int d = imp.getStackSize();
 			fData = new byte[d][];
 			for (int z = 0; z < d; z++)
 				fData[z] = (byte[]) stack.getPixels(z + 1);
+			if (compress) {
+				// the compressed voxels replace the slices
+				packed = CompressedBrickImage<byte>(fData, w, imp.getHeight(), d);
+				fData = null;
+				return;
+			}
+			voxels = ContiguousImage<byte>::fromSlices(fData, w, imp.getHeight(),
+				d, copy);
+			if (brickEdge > 0)
+				bricks = BrickedImage<byte>(fData, w, imp.getHeight(), d, brickEdge);
+		}
+
+		/** the slices of the ImageStack, or null if the image is compressed */
+		public const byte[][] getSlices() {
+			return fData;
+		}
+
+		public const ContiguousImage<byte>& getVoxels() {
+			return voxels;
+		}
+
+		public const BrickedImage<byte>& getBricks() {
+			return bricks;
+		}
+
+		public const CompressedBrickImage<byte>& getPacked() {
+			return packed;
 		}
 
 		@Override
 			public byte getAverage(final int x, final int y, final int z) {
+			if (!packed.empty()) return packed.get(x, y, z);
+			if (!bricks.empty()) return bricks.get(x, y, z);
+			if (!voxels.empty()) return voxels.get(x, y, z);
 			return fData[z][y * w + x];
 		}
 
 		@Override
 			public int get(final int x, final int y, final int z) {
+			if (!packed.empty()) return packed.get(x, y, z) & 0xff;
+			if (!bricks.empty()) return bricks.get(x, y, z) & 0xff;
+			if (!voxels.empty()) return voxels.get(x, y, z) & 0xff;
 			return fData[z][y * w + x] & 0xff;
 		}
 
+		@Override
+			public float getFloat(final int x, final int y, final int z) {
+			return get(x, y, z);
+		}
+
 		@Override
 			public void get(final int x, final int y, final int z, final int[] c) {
 			final int v = get(x, y, z);
@@ -554,7 +1173,15 @@ protected:
 
 		@Override
 			public void set(final int x, final int y, final int z, final int v) {
-			fData[z][y * w + x] = (byte)v;
+			// a compressed image has no slices; any other copy has to be
+			// kept in sync with the ImageStack
+			if (!packed.empty()) {
+				packed.set(x, y, z, (byte)v);
+				return;
+			}
+			if (!bricks.empty()) bricks.set(x, y, z, (byte)v);
+			if (!voxels.empty()) voxels.set(x, y, z, (byte)v);
+			if (voxels.empty() || !voxels.isView()) fData[z][y * w + x] = (byte)v;
 		}
 	}
 
@@ -563,18 +1190,56 @@ protected:
 		protected int[][] fData;
 		private final int w;
 
-		protected IntImage(final ImagePlus imp) {
+		/** the slices in one buffer, or empty; see setContiguous() */
+		protected ContiguousImage<int> voxels;
+
+		/** the voxels in bricks, or empty; see setBrickedLayout() */
+		protected BrickedImage<int> bricks;
+
+		/** the voxels compressed, or empty; see setCompressed() */
+		protected CompressedBrickImage<int> packed;
+
+		protected IntImage(final ImagePlus imp, final bool copy,
+			final int brickEdge, final bool compress)
+		{
 			final ImageStack stack = imp.getStack();
 			w = imp.getWidth();
 			final int d = imp.getStackSize();
 			fData = new int[d][];
 			for (int z = 0; z < d; z++)
 				fData[z] = (int[]) stack.getPixels(z + 1);
+			if (compress) {
+				// the compressed voxels replace the slices
+				packed = CompressedBrickImage<int>(fData, w, imp.getHeight(), d);
+				fData = null;
+				return;
+			}
+			voxels = ContiguousImage<int>::fromSlices(fData, w, imp.getHeight(),
+				d, copy);
+			if (brickEdge > 0)
+				bricks = BrickedImage<int>(fData, w, imp.getHeight(), d, brickEdge);
+		}
+
+		/** the slices of the ImageStack, or null if the image is compressed */
+		public const int[][] getSlices() {
+			return fData;
+		}
+
+		public const ContiguousImage<int>& getVoxels() {
+			return voxels;
+		}
+
+		public const BrickedImage<int>& getBricks() {
+			return bricks;
+		}
+
+		public const CompressedBrickImage<int>& getPacked() {
+			return packed;
 		}
 
 		@Override
 			public byte getAverage(final int x, final int y, final int z) {
-			final int v = fData[z][y * w + x];
+			final int v = get(x, y, z);
 			final int r = (v & 0xff0000) >> 16;
 			final int g = (v & 0xff00) >> 8;
 			final int b = (v & 0xff);
@@ -583,9 +1248,17 @@ protected:
 
 		@Override
 			public int get(final int x, final int y, final int z) {
+			if (!packed.empty()) return packed.get(x, y, z);
+			if (!bricks.empty()) return bricks.get(x, y, z);
+			if (!voxels.empty()) return voxels.get(x, y, z);
 			return fData[z][y * w + x];
 		}
 
+		@Override
+			public float getFloat(final int x, final int y, final int z) {
+			return get(x, y, z);
+		}
+
 		@Override
 			public void get(final int x, final int y, final int z, final int[] c) {
 			final int v = get(x, y, z);
@@ -596,7 +1269,215 @@ protected:
 
 		@Override
 			public void set(final int x, final int y, final int z, final int v) {
-			fData[z][y * w + x] = v;
+			// a compressed image has no slices; any other copy has to be
+			// kept in sync with the ImageStack
+			if (!packed.empty()) {
+				packed.set(x, y, z, v);
+				return;
+			}
+			if (!bricks.empty()) bricks.set(x, y, z, v);
+			if (!voxels.empty()) voxels.set(x, y, z, v);
+			if (voxels.empty() || !voxels.isView()) fData[z][y * w + x] = v;
+		}
+	}
+
+	/**
+	 * 16 bit gray values, unsigned. The LUTs and the average see them scaled
+	 * to 8 bits by the display range of the image, as ImageJ does when it
+	 * converts them to 8 bit.
+	 */
+	protected final class ShortImage implements InputImage {
+
+		protected short[][] fData;
+		private final int w;
+
+		/** the display range of the image, mapped to 0 - 255 */
+		private final int min;
+		private final double scale;
+
+		/** the slices in one buffer, or empty; see setContiguous() */
+		protected ContiguousImage<short> voxels;
+
+		/** the voxels in bricks, or empty; see setBrickedLayout() */
+		protected BrickedImage<short> bricks;
+
+		/** the voxels compressed, or empty; see setCompressed() */
+		protected CompressedBrickImage<short> packed;
+
+		protected ShortImage(final ImagePlus imp, final bool copy,
+			final int brickEdge, final bool compress)
+		{
+			final ImageStack stack = imp.getStack();
+			w = imp.getWidth();
+			min = (int)imp.getDisplayRangeMin();
+			scale = 256.0 / ((int)imp.getDisplayRangeMax() - min + 1);
+			final int d = imp.getStackSize();
+			fData = new short[d][];
+			for (int z = 0; z < d; z++)
+				fData[z] = (short[]) stack.getPixels(z + 1);
+			if (compress) {
+				// the compressed voxels replace the slices
+				packed = CompressedBrickImage<short>(fData, w, imp.getHeight(), d);
+				fData = null;
+				return;
+			}
+			voxels = ContiguousImage<short>::fromSlices(fData, w, imp.getHeight(),
+				d, copy);
+			if (brickEdge > 0)
+				bricks = BrickedImage<short>(fData, w, imp.getHeight(), d, brickEdge);
+		}
+
+		/** the slices of the ImageStack, or null if the image is compressed */
+		public const short[][] getSlices() {
+			return fData;
+		}
+
+		public const ContiguousImage<short>& getVoxels() {
+			return voxels;
+		}
+
+		public const BrickedImage<short>& getBricks() {
+			return bricks;
+		}
+
+		public const CompressedBrickImage<short>& getPacked() {
+			return packed;
+		}
+
+		@Override
+			public byte getAverage(final int x, final int y, final int z) {
+			return (byte)toByte(get(x, y, z));
+		}
+
+		/** v scaled by the display range, as by ShortProcessor.create8BitImage() */
+		private int toByte(final int v) {
+			return clamp((int)((v - min) * scale + 0.5), 0, 255);
+		}
+
+		@Override
+			public int get(final int x, final int y, final int z) {
+			if (!packed.empty()) return packed.get(x, y, z) & 0xffff;
+			if (!bricks.empty()) return bricks.get(x, y, z) & 0xffff;
+			if (!voxels.empty()) return voxels.get(x, y, z) & 0xffff;
+			return fData[z][y * w + x] & 0xffff;
+		}
+
+		@Override
+			public float getFloat(final int x, final int y, final int z) {
+			return get(x, y, z);
+		}
+
+		@Override
+			public void get(final int x, final int y, final int z, final int[] c) {
+			final int v = toByte(get(x, y, z));
+			c[0] = c[1] = c[2] = v;
+		}
+
+		@Override
+			public void set(final int x, final int y, final int z, final int v) {
+			// a compressed image has no slices; any other copy has to be
+			// kept in sync with the ImageStack
+			if (!packed.empty()) {
+				packed.set(x, y, z, (short)v);
+				return;
+			}
+			if (!bricks.empty()) bricks.set(x, y, z, (short)v);
+			if (!voxels.empty()) voxels.set(x, y, z, (short)v);
+			if (voxels.empty() || !voxels.isView()) fData[z][y * w + x] = (short)v;
+		}
+	}
+
+	/**
+	 * 32 bit float gray values. get() truncates them, getFloat() does not;
+	 * the LUTs and the average see them clamped to 0 - 255.
+	 */
+	protected final class FloatImage implements InputImage {
+
+		protected float[][] fData;
+		private final int w;
+
+		/** the slices in one buffer, or empty; see setContiguous() */
+		protected ContiguousImage<float> voxels;
+
+		/** the voxels in bricks, or empty; see setBrickedLayout() */
+		protected BrickedImage<float> bricks;
+
+		/** the voxels compressed, or empty; see setCompressed() */
+		protected CompressedBrickImage<float> packed;
+
+		protected FloatImage(final ImagePlus imp, final bool copy,
+			final int brickEdge, final bool compress)
+		{
+			final ImageStack stack = imp.getStack();
+			w = imp.getWidth();
+			final int d = imp.getStackSize();
+			fData = new float[d][];
+			for (int z = 0; z < d; z++)
+				fData[z] = (float[]) stack.getPixels(z + 1);
+			if (compress) {
+				// the compressed voxels replace the slices
+				packed = CompressedBrickImage<float>(fData, w, imp.getHeight(), d);
+				fData = null;
+				return;
+			}
+			voxels = ContiguousImage<float>::fromSlices(fData, w, imp.getHeight(),
+				d, copy);
+			if (brickEdge > 0)
+				bricks = BrickedImage<float>(fData, w, imp.getHeight(), d, brickEdge);
+		}
+
+		/** the slices of the ImageStack, or null if the image is compressed */
+		public const float[][] getSlices() {
+			return fData;
+		}
+
+		public const ContiguousImage<float>& getVoxels() {
+			return voxels;
+		}
+
+		public const BrickedImage<float>& getBricks() {
+			return bricks;
+		}
+
+		public const CompressedBrickImage<float>& getPacked() {
+			return packed;
+		}
+
+		@Override
+			public byte getAverage(final int x, final int y, final int z) {
+			return (byte)clamp(get(x, y, z), 0, 255);
+		}
+
+		@Override
+			public int get(final int x, final int y, final int z) {
+			return (int)getFloat(x, y, z);
+		}
+
+		@Override
+			public float getFloat(final int x, final int y, final int z) {
+			if (!packed.empty()) return packed.get(x, y, z);
+			if (!bricks.empty()) return bricks.get(x, y, z);
+			if (!voxels.empty()) return voxels.get(x, y, z);
+			return fData[z][y * w + x];
+		}
+
+		@Override
+			public void get(final int x, final int y, final int z, final int[] c) {
+			final int v = clamp(get(x, y, z), 0, 255);
+			c[0] = c[1] = c[2] = v;
+		}
+
+		@Override
+			public void set(final int x, final int y, final int z, final int v) {
+			// a compressed image has no slices; any other copy has to be
+			// kept in sync with the ImageStack
+			if (!packed.empty()) {
+				packed.set(x, y, z, (float)v);
+				return;
+			}
+			if (!bricks.empty()) bricks.set(x, y, z, (float)v);
+			if (!voxels.empty()) voxels.set(x, y, z, (float)v);
+			if (voxels.empty() || !voxels.isView()) fData[z][y * w + x] = (float)v;
 		}
 	}
 
@@ -711,11 +1592,10 @@ protected:
 			return image.get(x, y, z);
 		}
 
-		private final int[] color = new int[3];
-
 		@Override
 			public int loadWithLUT(final int x, final int y, final int z) {
 			// ByteLoader only is in use with a default LUT
+			int color[3];
 			image.get(x, y, z, color);
 			return color[channel];
 		}
@@ -739,16 +1619,18 @@ protected:
 			super(imp, 0);
 		}
 
-		private final int[] color = new int[3];
-
 		@Override
 			public final int load(final int x, final int y, final int z) {
-			image.get(x, y, z, color);
-			return (color[0] + color[1] + color[2]) / 3;
+			// local buffer: load() is called concurrently by MCCube workers
+			int c[3];
+			image.get(x, y, z, c);
+			return (c[0] + c[1] + c[2]) / 3;
 		}
 
 		@Override
 			public final int loadWithLUT(final int x, final int y, final int z) {
+			// local buffer, like load(): the byte cache is built concurrently
+			int color[3];
 			image.get(x, y, z, color);
 			int sum = 0, av = 0;
 			if (channels[0]) {
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VL_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "ContiguousImage.hpp"
+
+/**
+ * Loader policies over contiguous voxels, the compile time counterparts of
+ * the Loader classes of Volume. Each has an inline load(x, y, z) returning
+ * what Volume.load(x, y, z) returns for the same settings; the hot loops
+ * (MCCube, resampling, statistics) are templates over the policy, so that
+ * the loader is chosen once per volume (see Volume.withLoader()) and the
+ * per voxel access compiles down to a load from memory.
+ */
+namespace VoxelLoaders {
+
+	/** a stored value as an int: bytes and GRAY16 (a short) are unsigned */
+	template <typename T>
+	inline int toInt(T v) {
+		return (int)v;
+	}
+
+	inline int toInt(signed char v) {
+		return v & 0xff;
+	}
+
+	inline int toInt(short v) {
+		return v & 0xffff;
+	}
+
+	/**
+	 * ByteLoader and IntLoader: the value as it is stored, in a ContiguousImage
+	 * or a BrickedImage
+	 */
+	template <typename T, typename Image = ContiguousImage<T>>
+	struct Plain {
+		Image voxels;
+
+		explicit Plain(const Image& voxels) : voxels(voxels) {}
+
+		int load(int x, int y, int z) const {
+			return toInt(voxels.get(x, y, z));
+		}
+	};
+
+	/**
+	 * The value in the type it is stored in, for the loops templated on the
+	 * intensity type (see Volume.withNativeLoader()); used for GRAY32, whose
+	 * values Plain<float> truncates.
+	 */
+	template <typename T, typename Image = ContiguousImage<T>>
+	struct Native {
+		Image voxels;
+
+		explicit Native(const Image& voxels) : voxels(voxels) {}
+
+		T load(int x, int y, int z) const {
+			return voxels.get(x, y, z);
+		}
+	};
+
+	/** AverageByteLoader on RGB data: the mean of the three channels */
+	struct AverageRGB {
+		ContiguousImage<int> voxels;
+
+		explicit AverageRGB(const ContiguousImage<int>& voxels) : voxels(voxels) {}
+
+		int load(int x, int y, int z) const {
+			const int v = voxels.get(x, y, z);
+			return (((v & 0xff0000) >> 16) + ((v & 0xff00) >> 8) + (v & 0xff)) / 3;
+		}
+	};
+
+	/**
+	 * AverageByteLoader.loadWithLUT(): the mean of the selected channels,
+	 * each mapped through its LUT; gray values are used for all channels
+	 */
+	template <typename T>
+	struct AverageLUT {
+		ContiguousImage<T> voxels;
+		// the LUTs of the selected channels, null for the others
+		const int* luts[3];
+		int nChannels;
+
+		AverageLUT(const ContiguousImage<T>& voxels, const int* r, const int* g,
+			const int* b, const bool* channels) : voxels(voxels), nChannels(0)
+		{
+			const int* all[3] = { r, g, b };
+			for (int c = 0; c < 3; c++) {
+				luts[c] = channels[c] ? all[c] : nullptr;
+				if (channels[c]) nChannels++;
+			}
+		}
+
+		int load(int x, int y, int z) const {
+			if (nChannels == 0) return 0;
+			const int v = (int)voxels.get(x, y, z);
+			// for gray values, all shifts yield the value itself
+			const int shifts[3] = { sizeof(T) == 1 ? 0 : 16, sizeof(T) == 1 ? 0 : 8, 0 };
+			int sum = 0;
+			for (int c = 0; c < 3; c++)
+				if (luts[c] != nullptr) sum += luts[c][(v >> shifts[c]) & 0xff];
+			return sum / nChannels;
+		}
+	};
+
+	/**
+	 * writes loader.load(x, y, z) for the w voxels of the row (y, z) to out
+	 */
+	template <typename Loader>
+	void loadRow(const Loader& loader, int w, int y, int z, unsigned char* out) {
+		for (int x = 0; x < w; x++)
+			out[x] = (unsigned char)loader.load(x, y, z);
+	}
+
+	inline void loadRow(const AverageRGB& loader, int w, int y, int z,
+		unsigned char* out)
+	{
+		int x = 0;
+#if defined(VL_SSE2)
+		const int* row = loader.voxels.data + loader.voxels.index(0, y, z);
+		const __m128i mask = _mm_set1_epi32(0xff);
+		// s / 3 == (s * 0xaaab) >> 17 for s <= 765; the upper halves are 0
+		const __m128i third = _mm_set1_epi32(0xaaab);
+		for (; x + 4 <= w; x += 4) {
+			const __m128i v = _mm_loadu_si128((const __m128i*)(row + x));
+			__m128i s = _mm_and_si128(v, mask);
+			s = _mm_add_epi32(s, _mm_and_si128(_mm_srli_epi32(v, 8), mask));
+			s = _mm_add_epi32(s, _mm_and_si128(_mm_srli_epi32(v, 16), mask));
+			__m128i q = _mm_srli_epi32(_mm_mulhi_epu16(s, third), 1);
+			q = _mm_packs_epi32(q, q);
+			q = _mm_packus_epi16(q, q);
+			const int packed = _mm_cvtsi128_si32(q);
+			std::copy((const unsigned char*)&packed, (const unsigned char*)&packed + 4,
+				out + x);
+		}
+#endif
+		for (; x < w; x++)
+			out[x] = (unsigned char)loader.load(x, y, z);
+	}
+
+	/**
+	 * Writes loader.load(x, y, z) of every voxel of a w x h x d volume into a
+	 * new 8 bit volume, using nThreads threads, each on its own slices.
+	 */
+	template <typename Loader>
+	ContiguousImage<unsigned char> bake(const Loader& loader, int w, int h, int d,
+		int nThreads)
+	{
+		ContiguousImage<unsigned char> out(w, h, d);
+		if (nThreads <= 0)
+			nThreads = (int)std::thread::hardware_concurrency();
+		nThreads = std::max(1, std::min(nThreads, d));
+		std::vector<std::thread> workers;
+		for (int i = 0; i < nThreads; i++) {
+			const int z0 = (int)((long long)d * i / nThreads);
+			const int z1 = (int)((long long)d * (i + 1) / nThreads);
+			workers.push_back(std::thread([&loader, &out, w, h, z0, z1]() {
+				for (int z = z0; z < z1; z++)
+					for (int y = 0; y < h; y++)
+						loadRow(loader, w, y, z, out.data + out.index(0, y, z));
+			}));
+		}
+		for (size_t i = 0; i < workers.size(); i++)
+			workers[i].join();
+		return out;
+	}
+}